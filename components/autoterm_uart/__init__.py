@@ -1,6 +1,7 @@
 import esphome.config_validation as cv
 import esphome.codegen as cg
 from esphome import const
+from esphome.core import CORE
 import esphome.components.uart as uart
 import esphome.components.sensor as sensor
 import esphome.components.text_sensor as text_sensor
@@ -16,6 +17,10 @@ AutotermFanLevelNumber = autoterm_ns.class_("AutotermFanLevelNumber", number.Num
 AutotermUART = autoterm_ns.class_("AutotermUART", cg.Component)
 AutotermClimate = autoterm_ns.class_("AutotermClimate", climate.Climate)
 AutotermTempSourceSelect = autoterm_ns.class_("AutotermTempSourceSelect", select.Select)
+StatusSensor = autoterm_ns.enum("StatusSensor")
+LoopStage = autoterm_ns.enum("LoopStage")
+TelemetryCounter = autoterm_ns.enum("TelemetryCounter")
+PollPhase = cg.global_ns.namespace("autoterm").enum("PollPhase")
 
 CONF_CLIMATE = "climate"
 CONF_DEFAULT_LEVEL = "default_level"
@@ -26,9 +31,164 @@ CONF_THERMOSTAT_HYS_OFF = "thermostat_hysteresis_off"
 CONF_PANEL_TEMP_OVERRIDE = "panel_temp_override"
 CONF_PANEL_TEMP_OVERRIDE_SENSOR = "sensor"
 CONF_TEMP_SOURCE_SELECT = "temperature_source_select"
+CONF_CUT_THROUGH = "cut_through"
+CONF_CRC_TABLE = "crc_table"
+CONF_CRC_BENCHMARK = "crc_benchmark"
+CONF_DEADBAND = "deadband"
+CONF_PUBLISH_HEARTBEAT = "publish_heartbeat"
+CONF_LOOP_PROFILER = "loop_profiler"
+CONF_TELEMETRY = "telemetry"
+CONF_DISPLAY_TO_HEATER = "display_to_heater"
+CONF_HEATER_TO_DISPLAY = "heater_to_display"
+CONF_BUS_UTILISATION = "bus_utilisation"
+CONF_BRIDGE_TASK = "bridge_task"
+CONF_BRIDGE_FIRST = "bridge_first"
+CONF_CORE = "core"
+CONF_PRIORITY = "priority"
+CONF_AUTONOMOUS_POLL = "autonomous_poll"
+CONF_SETTINGS_REFRESH = "settings_refresh"
+CONF_DISPLAY_MISSED_FRAMES = "display_missed_frames"
+CONF_DISPLAY_TIMEOUT = "display_timeout"
 
 TEMP_SOURCE_OPTIONS = ["Intern", "Panel", "Extern", "Home Assistant"]
 
+# Statussensoren, die nur bei Änderung (oder per Heartbeat) veröffentlicht werden
+STATUS_SENSORS = {
+    "internal_temp": StatusSensor.STATUS_SENSOR_INTERNAL_TEMP,
+    "external_temp": StatusSensor.STATUS_SENSOR_EXTERNAL_TEMP,
+    "heater_temp": StatusSensor.STATUS_SENSOR_HEATER_TEMP,
+    "voltage": StatusSensor.STATUS_SENSOR_VOLTAGE,
+    "status": StatusSensor.STATUS_SENSOR_STATUS,
+    "fan_speed_set": StatusSensor.STATUS_SENSOR_FAN_SPEED_SET,
+    "fan_speed_actual": StatusSensor.STATUS_SENSOR_FAN_SPEED_ACTUAL,
+    "pump_frequency": StatusSensor.STATUS_SENSOR_PUMP_FREQUENCY,
+}
+
+# Abschnitte von loop(), deren p99-Laufzeit als Diagnosesensor veröffentlicht werden kann
+LOOP_STAGES = {
+    "total": LoopStage.LOOP_STAGE_TOTAL,
+    "forward_display": LoopStage.LOOP_STAGE_FORWARD_DISPLAY,
+    "forward_heater": LoopStage.LOOP_STAGE_FORWARD_HEATER,
+    "frame": LoopStage.LOOP_STAGE_FRAME,
+    "parse_status": LoopStage.LOOP_STAGE_PARSE_STATUS,
+    "parse_settings": LoopStage.LOOP_STAGE_PARSE_SETTINGS,
+    "commands": LoopStage.LOOP_STAGE_COMMANDS,
+    "poll": LoopStage.LOOP_STAGE_POLL,
+    "runtime": LoopStage.LOOP_STAGE_RUNTIME,
+    "thermostat": LoopStage.LOOP_STAGE_THERMOSTAT,
+    "trace": LoopStage.LOOP_STAGE_TRACE,
+}
+
+LOOP_PROFILER_SCHEMA = cv.Schema({
+    cv.Optional(key): sensor.sensor_schema(
+        unit_of_measurement="µs",
+        icon="mdi:timer-cog-outline",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+    for key in LOOP_STAGES
+})
+
+# Zähler je Richtung (Gesamtwerte seit dem Start)
+TELEMETRY_COUNTERS = {
+    "frames": TelemetryCounter.TELEMETRY_FRAMES,
+    "bytes": TelemetryCounter.TELEMETRY_BYTES,
+    "crc_errors": TelemetryCounter.TELEMETRY_CRC_ERRORS,
+    "passthrough_bytes": TelemetryCounter.TELEMETRY_PASSTHROUGH_BYTES,
+    "overflow_bytes": TelemetryCounter.TELEMETRY_OVERFLOW_BYTES,
+    "resyncs": TelemetryCounter.TELEMETRY_RESYNCS,
+    "false_starts": TelemetryCounter.TELEMETRY_FALSE_STARTS,
+    "gap_flushes": TelemetryCounter.TELEMETRY_GAP_FLUSHES,
+    "rewritten": TelemetryCounter.TELEMETRY_REWRITTEN,
+    "injected": TelemetryCounter.TELEMETRY_INJECTED,
+    "frames_start": TelemetryCounter.TELEMETRY_FRAMES_START,
+    "frames_settings": TelemetryCounter.TELEMETRY_FRAMES_SETTINGS,
+    "frames_standby": TelemetryCounter.TELEMETRY_FRAMES_STANDBY,
+    "frames_status": TelemetryCounter.TELEMETRY_FRAMES_STATUS,
+    "frames_panel_temperature": TelemetryCounter.TELEMETRY_FRAMES_PANEL_TEMPERATURE,
+    "frames_fan_only": TelemetryCounter.TELEMETRY_FRAMES_FAN_ONLY,
+    "frames_other": TelemetryCounter.TELEMETRY_FRAMES_OTHER,
+}
+
+TELEMETRY_DIRECTION_SCHEMA = cv.Schema({
+    **{
+        cv.Optional(key): sensor.sensor_schema(
+            icon="mdi:counter",
+            accuracy_decimals=0,
+            state_class=const.STATE_CLASS_TOTAL_INCREASING,
+            entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+        )
+        for key in TELEMETRY_COUNTERS
+    },
+    cv.Optional(CONF_BUS_UTILISATION): sensor.sensor_schema(
+        unit_of_measurement="%",
+        icon="mdi:gauge",
+        accuracy_decimals=1,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+})
+
+TELEMETRY_SCHEMA = cv.Schema({
+    cv.Optional(CONF_DISPLAY_TO_HEATER): TELEMETRY_DIRECTION_SCHEMA,
+    cv.Optional(CONF_HEATER_TO_DISPLAY): TELEMETRY_DIRECTION_SCHEMA,
+})
+
+# Weiterleitung in einem eigenen, fest gepinnten FreeRTOS-Task (nur ESP32)
+BRIDGE_TASK_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Optional(CONF_CORE, default=1): cv.int_range(min=0, max=1),
+        cv.Optional(CONF_PRIORITY, default=12): cv.int_range(min=1, max=24),
+    }),
+    cv.only_on_esp32,
+)
+
+# Statusintervall je Betriebsphase, solange kein Bedienteil abfragt
+POLL_PHASES = {
+    "standby": (PollPhase.POLL_PHASE_STANDBY, "10s"),
+    "startup": (PollPhase.POLL_PHASE_STARTUP, "500ms"),
+    "running": (PollPhase.POLL_PHASE_RUNNING, "2s"),
+    "shutdown": (PollPhase.POLL_PHASE_SHUTDOWN, "1s"),
+}
+
+AUTONOMOUS_POLL_SCHEMA = cv.Schema({
+    **{
+        cv.Optional(key, default=default): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=200)),
+        )
+        for key, (_, default) in POLL_PHASES.items()
+    },
+    cv.Optional(CONF_SETTINGS_REFRESH, default="10min"): cv.All(
+        cv.positive_time_period_milliseconds,
+        cv.Range(min=cv.TimePeriod(seconds=10)),
+    ),
+})
+
+# Teilsysteme, die nur bei passender Konfiguration einkompiliert werden (Define → Schlüssel)
+FEATURE_DEFINES = {
+    "AUTOTERM_UART_CLIMATE": [CONF_CLIMATE],
+    "AUTOTERM_UART_RUNTIME": ["runtime_hours", "session_runtime"],
+    "AUTOTERM_UART_PANEL_OVERRIDE": [CONF_PANEL_TEMP_OVERRIDE],
+    "AUTOTERM_UART_TEMP_SOURCE_SELECT": [CONF_TEMP_SOURCE_SELECT],
+}
+
+
+def validate_crc_table(value):
+    value = cv.one_of("flash", "ram", lower=True)(value)
+    # DRAM_ATTR gibt es nur auf den Espressif-Plattformen
+    if value == "ram" and CORE.is_host:
+        raise cv.Invalid("crc_table: ram is not available on the host platform")
+    return value
+
+
+def status_sensor_schema(deadband, **kwargs):
+    return sensor.sensor_schema(**kwargs).extend({
+        cv.Optional(CONF_DEADBAND, default=deadband): cv.positive_float,
+    })
+
+
 CLIMATE_SCHEMA = climate.climate_schema(AutotermClimate).extend({
     cv.Optional(CONF_DEFAULT_LEVEL, default=4): cv.int_range(min=0, max=9),
     cv.Optional(CONF_DEFAULT_TEMPERATURE, default=20.0): cv.temperature,
@@ -41,16 +201,30 @@ CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(AutotermUART),
     cv.Required("uart_display_id"): cv.use_id(uart.UARTComponent),
     cv.Required("uart_heater_id"): cv.use_id(uart.UARTComponent),
+    cv.Optional(CONF_CUT_THROUGH, default=False): cv.boolean,
+    cv.Optional(CONF_BRIDGE_FIRST, default=False): cv.boolean,
+    cv.Optional(CONF_CRC_TABLE, default="flash"): validate_crc_table,
+    cv.Optional(CONF_CRC_BENCHMARK, default=False): cv.boolean,
+    cv.Optional(CONF_PUBLISH_HEARTBEAT, default="60s"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_LOOP_PROFILER): LOOP_PROFILER_SCHEMA,
+    cv.Optional(CONF_TELEMETRY): TELEMETRY_SCHEMA,
+    cv.Optional(CONF_BRIDGE_TASK): BRIDGE_TASK_SCHEMA,
+    cv.Optional(CONF_AUTONOMOUS_POLL, default={}): AUTONOMOUS_POLL_SCHEMA,
+    cv.Optional(CONF_DISPLAY_MISSED_FRAMES, default=1): cv.int_range(min=1, max=10),
+    cv.Optional(CONF_DISPLAY_TIMEOUT, default="5s"): cv.All(
+        cv.positive_time_period_milliseconds,
+        cv.Range(min=cv.TimePeriod(milliseconds=500)),
+    ),
 
-    cv.Optional("internal_temp"): sensor.sensor_schema(unit_of_measurement="°C", icon="mdi:thermometer"),
-    cv.Optional("external_temp"): sensor.sensor_schema(unit_of_measurement="°C", icon="mdi:thermometer"),
-    cv.Optional("heater_temp"): sensor.sensor_schema(unit_of_measurement="°C", icon="mdi:thermometer"),
+    cv.Optional("internal_temp"): status_sensor_schema(0.0, unit_of_measurement="°C", icon="mdi:thermometer"),
+    cv.Optional("external_temp"): status_sensor_schema(0.0, unit_of_measurement="°C", icon="mdi:thermometer"),
+    cv.Optional("heater_temp"): status_sensor_schema(1.0, unit_of_measurement="°C", icon="mdi:thermometer"),
     cv.Optional("panel_temp"): sensor.sensor_schema(unit_of_measurement="°C", icon="mdi:thermometer"),
-    cv.Optional("voltage"): sensor.sensor_schema(unit_of_measurement="V", icon="mdi:flash"),
-    cv.Optional("status"): sensor.sensor_schema(icon="mdi:information"),
-    cv.Optional("fan_speed_set"): sensor.sensor_schema(unit_of_measurement="rpm", icon="mdi:fan"),
-    cv.Optional("fan_speed_actual"): sensor.sensor_schema(unit_of_measurement="rpm", icon="mdi:fan"),
-    cv.Optional("pump_frequency"): sensor.sensor_schema(unit_of_measurement="Hz", icon="mdi:water-pump"),
+    cv.Optional("voltage"): status_sensor_schema(0.2, unit_of_measurement="V", icon="mdi:flash"),
+    cv.Optional("status"): status_sensor_schema(0.0, icon="mdi:information"),
+    cv.Optional("fan_speed_set"): status_sensor_schema(0.0, unit_of_measurement="rpm", icon="mdi:fan"),
+    cv.Optional("fan_speed_actual"): status_sensor_schema(60.0, unit_of_measurement="rpm", icon="mdi:fan"),
+    cv.Optional("pump_frequency"): status_sensor_schema(0.05, unit_of_measurement="Hz", icon="mdi:water-pump"),
     cv.Optional("runtime_hours"): sensor.sensor_schema(
         unit_of_measurement="h",
         icon="mdi:clock-outline",
@@ -66,6 +240,42 @@ CONFIG_SCHEMA = cv.Schema({
         state_class=const.STATE_CLASS_MEASUREMENT,
     ),
 
+    cv.Optional("response_time_p50"): sensor.sensor_schema(
+        unit_of_measurement="ms",
+        icon="mdi:timer-sand",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    cv.Optional("response_time_p95"): sensor.sensor_schema(
+        unit_of_measurement="ms",
+        icon="mdi:timer-sand",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    cv.Optional("request_timeouts"): sensor.sensor_schema(
+        icon="mdi:timer-alert-outline",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_TOTAL_INCREASING,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    cv.Optional("first_forward_time"): sensor.sensor_schema(
+        unit_of_measurement="ms",
+        icon="mdi:timer-play-outline",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+
+    cv.Optional("display_failover_time"): sensor.sensor_schema(
+        unit_of_measurement="ms",
+        icon="mdi:swap-horizontal",
+        accuracy_decimals=0,
+        state_class=const.STATE_CLASS_MEASUREMENT,
+        entity_category=const.ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+
     cv.Optional("status_text"): text_sensor.text_sensor_schema(icon="mdi:information"),
 
     cv.Optional("fan_level"): number.number_schema(class_=AutotermFanLevelNumber, icon="mdi:fan-speed-1"),
@@ -86,6 +296,45 @@ async def to_code(config):
     heat = await cg.get_variable(config["uart_heater_id"])
     cg.add(var.set_uart_display(disp))
     cg.add(var.set_uart_heater(heat))
+    cg.add(var.set_cut_through(config[CONF_CUT_THROUGH]))
+    cg.add(var.set_bridge_first(config[CONF_BRIDGE_FIRST]))
+    cg.add(var.set_publish_heartbeat(config[CONF_PUBLISH_HEARTBEAT]))
+    poll_conf = config[CONF_AUTONOMOUS_POLL]
+    for key, (phase, _) in POLL_PHASES.items():
+        cg.add(var.set_poll_interval(phase, poll_conf[key]))
+    cg.add(var.set_settings_refresh_interval(poll_conf[CONF_SETTINGS_REFRESH]))
+    cg.add(var.set_display_missed_frames(config[CONF_DISPLAY_MISSED_FRAMES]))
+    cg.add(var.set_display_timeout(config[CONF_DISPLAY_TIMEOUT]))
+    for define, keys in FEATURE_DEFINES.items():
+        if any(key in config for key in keys):
+            cg.add_define(define)
+    if config[CONF_CRC_TABLE] == "ram":
+        # Build-Flag statt Define, da der Protokoll-Kern keine ESPHome-Header einbindet
+        cg.add_build_flag("-DAUTOTERM_UART_CRC_TABLE_IN_RAM")
+    if config[CONF_CRC_BENCHMARK]:
+        cg.add_define("AUTOTERM_UART_CRC_BENCHMARK")
+    if CONF_BRIDGE_TASK in config:
+        cg.add_define("AUTOTERM_UART_BRIDGE_TASK")
+        task_conf = config[CONF_BRIDGE_TASK]
+        cg.add(var.set_bridge_task(task_conf[CONF_CORE], task_conf[CONF_PRIORITY]))
+    if CONF_LOOP_PROFILER in config:
+        cg.add_define("AUTOTERM_UART_PROFILE")
+        profiler_conf = config[CONF_LOOP_PROFILER]
+        for key, stage in LOOP_STAGES.items():
+            if key in profiler_conf:
+                sens = await sensor.new_sensor(profiler_conf[key])
+                cg.add(var.set_loop_stage_sensor(stage, sens))
+
+    if CONF_TELEMETRY in config:
+        for direction, from_display in [(CONF_DISPLAY_TO_HEATER, True), (CONF_HEATER_TO_DISPLAY, False)]:
+            direction_conf = config[CONF_TELEMETRY].get(direction, {})
+            for key, counter in [
+                *TELEMETRY_COUNTERS.items(),
+                (CONF_BUS_UTILISATION, TelemetryCounter.TELEMETRY_BUS_UTILISATION),
+            ]:
+                if key in direction_conf:
+                    sens = await sensor.new_sensor(direction_conf[key])
+                    cg.add(var.set_telemetry_sensor(from_display, counter, sens))
 
     for key, setter in [
         ("internal_temp", "set_internal_temp_sensor"),
@@ -99,10 +348,17 @@ async def to_code(config):
         ("pump_frequency", "set_pump_frequency_sensor"),
         ("runtime_hours", "set_runtime_hours_sensor"),
         ("session_runtime", "set_session_runtime_sensor"),
+        ("response_time_p50", "set_response_time_p50_sensor"),
+        ("response_time_p95", "set_response_time_p95_sensor"),
+        ("request_timeouts", "set_request_timeouts_sensor"),
+        ("first_forward_time", "set_first_forward_sensor"),
+        ("display_failover_time", "set_display_failover_sensor"),
     ]:
         if key in config:
             sens = await sensor.new_sensor(config[key])
             cg.add(getattr(var, setter)(sens))
+            if key in STATUS_SENSORS:
+                cg.add(var.set_publish_deadband(STATUS_SENSORS[key], config[key][CONF_DEADBAND]))
 
     for key, setter in [
         ("status_text", "set_status_text_sensor"),
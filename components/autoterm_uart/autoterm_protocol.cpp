@@ -0,0 +1,791 @@
+#include "autoterm_protocol.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace autoterm {
+
+// ===================
+// BridgeChannel
+// ===================
+void BridgeChannel::push(uint8_t b, uint32_t now_us, ByteSink &sink, BridgeChannelListener &listener) {
+  last_byte_us_ = now_us;
+  BridgeFrameAssembler::Result result = assembler_.push(b);
+  if (result != BridgeFrameAssembler::Result::PASSTHROUGH) {
+    if (b == FRAME_START)
+      note_start_byte_(now_us);
+    buffered_total_++;
+  }
+  for (;;) {
+    switch (result) {
+      case BridgeFrameAssembler::Result::PASSTHROUGH:
+        // Schraube lose Bytes vor dem Header direkt durch
+        sink.write(&b, 1);
+        return;
+      case BridgeFrameAssembler::Result::RESYNC:
+        // Verworfenen Kandidaten roh weitergeben, dann ab dem nächsten 0xAA weiter
+        release_(assembler_.skip_length(), sink);
+        if (forwarded_ == 0) {
+          reset_frame_();
+          frame_start_us_ = candidate_start_us_(now_us);
+        } else {
+          // Cut-Through hat den neuen Kandidaten schon angefangen: durchlaufen lassen
+          decided_ = true;
+          hold_ = false;
+        }
+        result = assembler_.resume();
+        continue;
+      case BridgeFrameAssembler::Result::PENDING:
+        if (assembler_.size() == 1)
+          frame_start_us_ = now_us;
+        if (cut_through_)
+          cut_through_pending_(now_us, sink, listener);
+        return;
+      case BridgeFrameAssembler::Result::FRAME: {
+        size_t total = assembler_.frame_length();
+        bool forwarded = cut_through_ && decided_ && !hold_;
+        if (forwarded)
+          forward_buffered_(sink, total);
+
+        assembler_.copy_to(frame_, total);
+        assembler_.discard(total);
+        bool valid = assembler_.frame_crc_valid();
+        reset_frame_();
+        telemetry_.commands[command_slot(frame_[4])].add();
+        if (!valid)
+          telemetry_.crc_errors.add();
+        if (!forwarded) {
+          if (valid && listener.rewrite_frame(*this, frame_, total))
+            telemetry_.rewritten.add();
+          latency_.add(now_us - frame_start_us_);
+          sink.write(frame_, total);
+          sink.frame_complete();
+        }
+        listener.on_frame(*this, frame_, total, valid);
+        // Nach einem Resync können schon Bytes des nächsten Frames im Puffer liegen
+        if (assembler_.empty())
+          return;
+        frame_start_us_ = candidate_start_us_(now_us);
+        result = assembler_.resume();
+        continue;
+      }
+    }
+  }
+}
+
+void BridgeChannel::poll_gap(uint32_t now_us, ByteSink &sink) {
+  if (assembler_.empty() || (now_us - last_byte_us_) <= frame_gap_us_)
+    return;
+  release_(assembler_.flush_partial(), sink);
+  reset_frame_();
+}
+
+// Gibt die ersten length Bytes des Puffers roh weiter; was Cut-Through schon
+// gesendet hat, wird nur verworfen
+void BridgeChannel::release_(size_t length, ByteSink &sink) {
+  size_t already = std::min(forwarded_, length);
+  assembler_.discard(already);
+  forwarded_ -= already;
+  uint8_t raw;
+  for (size_t i = already; i < length && assembler_.pop(&raw); i++)
+    sink.write(&raw, 1);
+}
+
+// Cut-Through: sobald der Funktionscode bekannt ist, wird entschieden, ob der
+// Frame umgeschrieben werden könnte. Alle anderen Frames laufen sofort durch.
+void BridgeChannel::cut_through_pending_(uint32_t now_us, ByteSink &sink, BridgeChannelListener &listener) {
+  if (!decided_) {
+    if (assembler_.size() < FRAME_HEADER_LENGTH)
+      return;
+    decided_ = true;
+    hold_ = listener.may_rewrite_frame(*this, assembler_[1], assembler_[4]);
+    if (hold_)
+      return;
+    latency_.add(now_us - frame_start_us_);
+  } else if (hold_) {
+    return;
+  }
+  forward_buffered_(sink, assembler_.size());
+}
+
+void BridgeChannel::forward_buffered_(ByteSink &sink, size_t end) {
+  for (size_t i = forwarded_; i < end; i++) {
+    uint8_t b = assembler_[i];
+    sink.write(&b, 1);
+  }
+  forwarded_ = end;
+}
+
+void BridgeChannel::note_start_byte_(uint32_t now_us) {
+  start_marks_[start_mark_next_] = StartMark{buffered_total_, now_us};
+  start_mark_next_ = static_cast<uint8_t>((start_mark_next_ + 1) % START_MARKS);
+}
+
+uint32_t BridgeChannel::candidate_start_us_(uint32_t fallback_us) const {
+  uint32_t position = buffered_total_ - static_cast<uint32_t>(assembler_.size());
+  for (const StartMark &mark : start_marks_) {
+    if (mark.position == position)
+      return mark.time_us;
+  }
+  return fallback_us;
+}
+
+void BridgeChannel::reset_frame_() {
+  forwarded_ = 0;
+  decided_ = false;
+  hold_ = false;
+}
+
+size_t format_hex(const uint8_t *data, size_t length, char *out, size_t out_size) {
+  static const char digits[] = "0123456789ABCDEF";
+  if (out_size == 0)
+    return 0;
+  size_t pos = 0;
+  for (size_t i = 0; i < length && pos + 3 <= out_size - 1; i++) {
+    if (i > 0)
+      out[pos++] = ' ';
+    out[pos++] = digits[data[i] >> 4];
+    out[pos++] = digits[data[i] & 0x0F];
+  }
+  out[pos] = '\0';
+  return pos;
+}
+
+// ===================
+// Dekodierung
+// ===================
+float StatusFrame::heater_temp() const {
+  uint16_t raw = (static_cast<uint16_t>(p_[7]) << 8) | p_[8];
+  if (raw == 0xFFFF)
+    return NAN;
+  return (static_cast<float>(raw) - 0x100) / 2;
+}
+
+void StatusFrame::decode(Status &out) const {
+  out.code = code();
+  out.value = p_[0] + (p_[1] / 10.0f);
+  out.internal_temp = internal_temp();
+  out.external_temp = external_temp();
+  out.voltage = voltage();
+  out.heater_temp = heater_temp();
+  out.fan_set_rpm = fan_set_rpm();
+  out.fan_actual_rpm = fan_actual_rpm();
+  out.pump_frequency = pump_frequency();
+}
+
+bool decode_status(const uint8_t *frame, size_t length, Status &out) {
+  FrameView view(frame, length);
+  if (!view.valid() || !StatusFrame::matches(view)) return false;
+  StatusFrame(view).decode(out);
+  return true;
+}
+
+bool decode_settings(const uint8_t *frame, size_t length, Settings &out) {
+  FrameView view(frame, length);
+  if (!view.valid() || !SettingsFrame::matches(view)) return false;
+  SettingsFrame(view).decode(out);
+  return true;
+}
+
+bool is_panel_temperature_frame(const uint8_t *frame, size_t length) {
+  FrameView view(frame, length);
+  return view.valid() && PanelTempFrame::matches(view);
+}
+
+const char *status_text(uint16_t status_code) {
+  switch (status_code) {
+    case 0x0001: return "Standby";
+    case 0x0100: return "Flammensensor kühlt";
+    case 0x0101: return "Lüftung";
+    case 0x0200: return "Heizung wird vorbereitet";
+    case 0x0201: return "Glühkerze heizt";
+    case 0x0202: return "Zündung 1";
+    case 0x0203: return "Zündung 2";
+    case 0x0204: return "Brennkammer heizt";
+    case 0x0300: return "Heizen";
+    case 0x0323: return "Nur Lüfter";
+    case 0x0304: return "Kühlt ab";
+    case 0x0305: return "Nachlauf-Lüftung";
+    case 0x0400: return "Herunterfahren";
+    default: return nullptr;
+  }
+}
+
+bool is_heater_active_status(uint16_t status_code) {
+  if (status_code == 0x0000 || status_code == 0x0001)
+    return false;
+  return true;
+}
+
+void patch_frame_byte(uint8_t *frame, size_t length, size_t index, uint8_t value) {
+  if (length < 3 || index >= length - FRAME_CRC_LENGTH)
+    return;
+  size_t crc_pos = length - FRAME_CRC_LENGTH;
+  uint16_t crc = static_cast<uint16_t>((frame[crc_pos] << 8) | frame[crc_pos + 1]);
+  crc = crc16_modbus_patch(crc, frame[index], value, crc_pos - index - 1);
+  frame[index] = value;
+  frame[crc_pos] = (crc >> 8) & 0xFF;
+  frame[crc_pos + 1] = crc & 0xFF;
+}
+
+bool PublishFilter::should_publish(float value, uint32_t now_ms, uint32_t heartbeat_ms) const {
+  if (!published_)
+    return true;
+  if (heartbeat_ms > 0 && (now_ms - last_publish_ms_) >= heartbeat_ms)
+    return true;
+  bool was_nan = std::isnan(last_value_);
+  if (std::isnan(value) || was_nan)
+    return std::isnan(value) != was_nan;
+  float delta = std::fabs(value - last_value_);
+  // kleine Toleranz, damit 0.1-Schritte bei deadband 0.1 nicht an Rundung scheitern
+  return delta > 0.0f && delta + 1e-4f >= deadband_;
+}
+
+// ===================
+// Kommando-Encoder
+// ===================
+uint8_t map_temp_source_to_heater(uint8_t source) {
+  switch (source) {
+    case 1: return 0x01;
+    case 2: return 0x02;
+    case 3: return 0x03;
+    case 4: return 0x02;  // Home Assistant meldet sich gegenüber der Heizung als Panelsensor
+    default: return source > 4 ? 0x02 : 0x01;
+  }
+}
+
+CommandFrameBytes<6> power_mode_frame(bool start, uint8_t level) {
+  uint8_t clamped_level = std::min<uint8_t>(level, 9);
+  return build_command_frame<6>(start ? CMD_START : CMD_SETTINGS, {0xFF, 0xFF, 0x04, 0xFF, 0x02, clamped_level});
+}
+
+CommandFrameBytes<6> temperature_hold_mode_frame(bool start, uint8_t heater_sensor, uint8_t set_temp) {
+  uint8_t temp_byte = std::min<uint8_t>(set_temp, 30);
+  return build_command_frame<6>(start ? CMD_START : CMD_SETTINGS, {0xFF, 0xFF, heater_sensor, temp_byte, 0x02, 0xFF});
+}
+
+CommandFrameBytes<6> temperature_to_fan_mode_frame(bool start, uint8_t heater_sensor, uint8_t set_temp) {
+  uint8_t temp_byte = std::min<uint8_t>(set_temp, 30);
+  return build_command_frame<6>(start ? CMD_START : CMD_SETTINGS, {0xFF, 0xFF, heater_sensor, temp_byte, 0x01, 0xFF});
+}
+
+CommandFrameBytes<4> fan_only_frame(uint8_t level) {
+  uint8_t clamped_level = std::min<uint8_t>(level, 9);
+  return build_command_frame<4>(CMD_FAN_ONLY, {0xFF, 0xFF, clamped_level, 0xFF});
+}
+
+CommandFrameBytes<6> thermostat_cooldown_frame(uint8_t heater_sensor, uint8_t set_temp) {
+  uint8_t clamped_temp = std::min<uint8_t>(set_temp, 30);
+  return build_command_frame<6>(CMD_SETTINGS, {0xFF, 0xFF, heater_sensor, clamped_temp, 0x01, 0xFF});
+}
+
+CommandFrameBytes<1> panel_temperature_frame(uint8_t temperature) {
+  return build_command_frame<1>(CMD_PANEL_TEMPERATURE, {temperature});
+}
+
+bool settings_command_is_redundant(const uint8_t *frame, size_t length, const Settings &confirmed) {
+  if (length != MAX_COMMAND_FRAME_LENGTH || frame[4] != CMD_SETTINGS)
+    return false;
+  const uint8_t *p = &frame[FRAME_HEADER_LENGTH];
+  const uint8_t current[] = {confirmed.use_work_time,   confirmed.work_time, confirmed.temperature_source,
+                             confirmed.set_temperature, confirmed.wait_mode, confirmed.power_level};
+  for (size_t i = 0; i < MAX_COMMAND_PAYLOAD; i++) {
+    if (p[i] != 0xFF && p[i] != current[i])
+      return false;
+  }
+  return true;
+}
+
+SettingsMode settings_mode(const Settings &settings) {
+  if (settings.wait_mode == 0x00 && settings.power_level == 0)
+    return SettingsMode::STANDBY;
+  if (settings.temperature_source == 0x04)
+    return SettingsMode::POWER;
+  if (settings.wait_mode == 0x01)
+    return SettingsMode::HEAT_FAN;
+  if (settings.wait_mode == 0x02)
+    return SettingsMode::HEAT;
+  return SettingsMode::UNKNOWN;
+}
+
+// ===================
+// CommandScheduler
+// ===================
+bool is_request_frame(const uint8_t *frame, size_t length) {
+  return length == FRAME_OVERHEAD && frame[4] != CMD_STANDBY;
+}
+
+static bool is_mode_command(uint8_t command, bool request) {
+  if (request)
+    return false;
+  return command == CMD_START || command == CMD_SETTINGS || command == CMD_STANDBY || command == CMD_FAN_ONLY;
+}
+
+CommandScheduler::Submit CommandScheduler::submit(const uint8_t *frame, size_t length, const char *label,
+                                                  const Settings *confirmed) {
+  if (length < FRAME_OVERHEAD || length > MAX_COMMAND_FRAME_LENGTH)
+    return Submit::FULL;
+  stats_.submitted++;
+
+  uint8_t command = frame[4];
+  bool request = is_request_frame(frame, length);
+  bool coalesced = false;
+
+  // Gleiches Kommando wartet noch: der neue Wert ersetzt es
+  int existing = find_(command, request);
+  if (existing >= 0) {
+    remove_(static_cast<size_t>(existing));
+    coalesced = true;
+  }
+
+  if (!request && command == CMD_STANDBY) {
+    // Standby macht wartende Start-/Settings-/Lüfterkommandos überflüssig
+    for (size_t i = count_; i-- > 0;) {
+      const ScheduledCommand &slot = slots_[i];
+      if (is_mode_command(slot.frame[4], is_request_frame(slot.frame, slot.length))) {
+        remove_(i);
+        coalesced = true;
+      }
+    }
+  }
+
+  ScheduledCommand entry;
+  std::copy(frame, frame + length, entry.frame);
+  entry.length = static_cast<uint8_t>(length);
+  entry.label = label;
+
+  if (!request && command == CMD_SETTINGS) {
+    // Neue Sollwerte für einen wartenden Start übernehmen, statt ihn zu verlieren
+    int start = find_(CMD_START, false);
+    if (start >= 0 && slots_[start].length == length) {
+      patch_frame_byte(entry.frame, length, 4, CMD_START);
+      entry.label = slots_[start].label;
+      remove_(static_cast<size_t>(start));
+      coalesced = true;
+    } else if (confirmed != nullptr && !settings_pending_ && settings_command_is_redundant(frame, length, *confirmed)) {
+      if (coalesced)
+        stats_.coalesced++;
+      stats_.redundant++;
+      return Submit::REDUNDANT;
+    }
+  } else if (!request && command == CMD_START) {
+    int settings = find_(CMD_SETTINGS, false);
+    if (settings >= 0) {
+      remove_(static_cast<size_t>(settings));
+      coalesced = true;
+    }
+  }
+
+  if (count_ == SLOTS) {
+    stats_.dropped++;
+    return Submit::FULL;
+  }
+  slots_[count_++] = entry;
+  if (coalesced) {
+    stats_.coalesced++;
+    return Submit::COALESCED;
+  }
+  return Submit::QUEUED;
+}
+
+bool CommandScheduler::ready(uint32_t now_ms, bool line_busy) const {
+  if (count_ == 0 || line_busy)
+    return false;
+  if (awaiting_response_ && (now_ms - request_ms_) < RESPONSE_TIMEOUT_MS)
+    return false;
+  return (now_ms - last_activity_ms_) >= IDLE_GAP_MS;
+}
+
+bool CommandScheduler::pop(uint32_t now_ms, ScheduledCommand &out) {
+  if (count_ == 0)
+    return false;
+  out = slots_[0];
+  remove_(0);
+  stats_.injected++;
+  if (is_mode_command(out.frame[4], is_request_frame(out.frame, out.length)))
+    settings_pending_ = true;
+  note_request(now_ms);
+  return true;
+}
+
+bool CommandScheduler::has_pending(const uint8_t *frame, size_t length) const {
+  if (length < FRAME_OVERHEAD)
+    return false;
+  return find_(frame[4], is_request_frame(frame, length)) >= 0;
+}
+
+size_t CommandScheduler::drop_requests() {
+  size_t dropped = 0;
+  for (size_t i = count_; i-- > 0;) {
+    if (is_request_frame(slots_[i].frame, slots_[i].length)) {
+      remove_(i);
+      dropped++;
+    }
+  }
+  return dropped;
+}
+
+void CommandScheduler::remove_(size_t index) {
+  for (size_t i = index + 1; i < count_; i++)
+    slots_[i - 1] = slots_[i];
+  count_--;
+}
+
+int CommandScheduler::find_(uint8_t command, bool request) const {
+  for (size_t i = 0; i < count_; i++) {
+    if (slots_[i].frame[4] == command && is_request_frame(slots_[i].frame, slots_[i].length) == request)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// ===================
+// RequestTracker
+// ===================
+void RequestTracker::on_request(const uint8_t *frame, size_t length, uint32_t sent_ms, bool own,
+                                const char *label) {
+  if (length < FRAME_OVERHEAD || length > MAX_COMMAND_FRAME_LENGTH)
+    return;
+  int index = find_(frame[4]);
+  if (index < 0) {
+    for (size_t i = 0; i < SLOTS; i++) {
+      if (slots_[i].state == State::FREE) {
+        index = static_cast<int>(i);
+        break;
+      }
+    }
+    if (index < 0)
+      return;
+    slots_[index].attempts = 0;
+    slots_[index].own = false;
+  } else if (slots_[index].state == State::RETRY && own) {
+    // Wiederholung der eigenen Anfrage
+    slots_[index].attempts++;
+  } else {
+    // Neue Anfrage übernimmt den Slot samt Besitz; eine des Bedienteils erbt keine Wiederholung
+    slots_[index].attempts = 0;
+    slots_[index].own = false;
+    slots_[index].request = ScheduledCommand{};
+  }
+
+  Slot &slot = slots_[index];
+  slot.state = State::IN_FLIGHT;
+  slot.command = frame[4];
+  slot.own = slot.own || own;
+  slot.sent_ms = sent_ms;
+  if (own) {
+    std::copy(frame, frame + length, slot.request.frame);
+    slot.request.length = static_cast<uint8_t>(length);
+    slot.request.label = label;
+  }
+}
+
+bool RequestTracker::on_response(uint8_t command, uint32_t now_ms) {
+  int index = find_(command);
+  if (index < 0) {
+    stats_.unmatched++;
+    return false;
+  }
+  Slot &slot = slots_[index];
+  int32_t rtt = static_cast<int32_t>(now_ms - slot.sent_ms);
+  latency_.add(rtt > 0 ? static_cast<uint32_t>(rtt) : 0);
+  stats_.matched++;
+  slot = Slot{};
+  return true;
+}
+
+bool RequestTracker::poll(uint32_t now_ms, ScheduledCommand &retry) {
+  for (auto &slot : slots_) {
+    if (slot.state == State::FREE)
+      continue;
+    int32_t elapsed = static_cast<int32_t>(now_ms - slot.sent_ms);
+    if (slot.state == State::RETRY) {
+      // Wiederholung kam nie auf die Leitung (z. B. Warteschlange voll)
+      if (elapsed >= 0 && static_cast<uint32_t>(elapsed) >= timeout_ms_(MAX_RETRIES + 1)) {
+        stats_.timeouts++;
+        slot = Slot{};
+      }
+      continue;
+    }
+    if (elapsed < 0 || static_cast<uint32_t>(elapsed) < timeout_ms_(slot.attempts))
+      continue;
+
+    // Nur Abfragen wiederholen: ein verspätet beantworteter Start käme sonst doppelt an
+    bool retryable = slot.own && is_request_frame(slot.request.frame, slot.request.length);
+    if (!retryable || slot.attempts >= MAX_RETRIES) {
+      stats_.timeouts++;
+      slot = Slot{};
+      continue;
+    }
+    stats_.retries++;
+    slot.state = State::RETRY;
+    retry = slot.request;
+    return true;
+  }
+  return false;
+}
+
+void RequestTracker::cancel(uint8_t command) {
+  int index = find_(command);
+  if (index >= 0)
+    release_(slots_[index]);
+}
+
+void RequestTracker::cancel_own() {
+  for (auto &slot : slots_) {
+    if (slot.state != State::FREE && slot.own)
+      release_(slot);
+  }
+}
+
+void RequestTracker::release_(Slot &slot) {
+  // Eine ausgegebene, aber nie gesendete Wiederholung zählt nicht
+  if (slot.state == State::RETRY && stats_.retries > 0)
+    stats_.retries--;
+  slot = Slot{};
+}
+
+int RequestTracker::find_(uint8_t command) const {
+  for (size_t i = 0; i < SLOTS; i++) {
+    if (slots_[i].state != State::FREE && slots_[i].command == command)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// ===================
+// ThermostatEngine
+// ===================
+ThermostatAction ThermostatEngine::configure(const ThermostatConfig &config, uint32_t now_ms) {
+  active_ = true;
+  config_ = config;
+  if (last_sent_level_ == NO_LEVEL)
+    last_sent_level_ = config_.level;
+
+  if (heating_request_ && last_sent_level_ != config_.level) {
+    last_command_ms_ = now_ms;
+    last_sent_level_ = config_.level;
+    return ThermostatAction::ADJUST_LEVEL;
+  }
+  if (!heating_request_)
+    last_sent_level_ = config_.level;
+  return ThermostatAction::NONE;
+}
+
+void ThermostatEngine::restore(const ThermostatConfig &config) {
+  active_ = true;
+  config_ = config;
+  last_sent_level_ = config_.level;
+  resync_ = true;
+}
+
+void ThermostatEngine::deactivate() {
+  active_ = false;
+  heating_request_ = false;
+  waiting_for_idle_ = false;
+  last_sent_level_ = NO_LEVEL;
+  resync_ = false;
+}
+
+uint8_t ThermostatEngine::cooldown_temperature() const {
+  float cooldown_target = std::max(0.0f, config_.target_c - COOLDOWN_OFFSET_C);
+  return static_cast<uint8_t>(std::round(std::min(30.0f, cooldown_target)));
+}
+
+ThermostatAction ThermostatEngine::evaluate(float current_c, bool heater_running, uint32_t now_ms, bool force) {
+  if (!active_)
+    return ThermostatAction::NONE;
+  if (!force && (now_ms - last_evaluation_ms_) < EVALUATION_INTERVAL_MS)
+    return ThermostatAction::NONE;
+  last_evaluation_ms_ = now_ms;
+  if (!std::isfinite(current_c))
+    return ThermostatAction::NONE;
+
+  float on_threshold = config_.target_c - config_.hys_on_c;
+  float off_threshold = config_.target_c + config_.hys_off_c;
+
+  if (!heating_request_ && !waiting_for_idle_) {
+    if (current_c >= on_threshold || command_recent_(now_ms))
+      return ThermostatAction::NONE;
+    ThermostatAction action = ThermostatAction::CLAIM;
+    if (!heater_running) {
+      action = ThermostatAction::START;
+      last_command_ms_ = now_ms;
+    } else if (last_sent_level_ != config_.level) {
+      action = ThermostatAction::SET_LEVEL;
+      last_command_ms_ = now_ms;
+    }
+    last_sent_level_ = config_.level;
+    heating_request_ = true;
+    return action;
+  }
+
+  if (heating_request_) {
+    if (current_c > off_threshold) {
+      if (command_recent_(now_ms))
+        return ThermostatAction::NONE;
+      heating_request_ = false;
+      waiting_for_idle_ = true;
+      last_command_ms_ = now_ms;
+      return ThermostatAction::COOLDOWN;
+    }
+    if (last_sent_level_ != config_.level && (now_ms - last_command_ms_) > LEVEL_ADJUST_GUARD_MS) {
+      last_command_ms_ = now_ms;
+      last_sent_level_ = config_.level;
+      return ThermostatAction::ADJUST_LEVEL;
+    }
+  }
+  return ThermostatAction::NONE;
+}
+
+ThermostatAction ThermostatEngine::on_status(uint16_t status_code, uint32_t now_ms) {
+  if (!active_)
+    return ThermostatAction::NONE;
+
+  bool heater_active = is_heater_active_status(status_code);
+  if (resync_) {
+    // Nach dem Neustart übernimmt der Thermostat den laufenden Heizbetrieb
+    heating_request_ = heater_active;
+    resync_ = false;
+  }
+
+  if (!waiting_for_idle_ && !heater_active)
+    heating_request_ = false;
+
+  if (waiting_for_idle_) {
+    if (status_code == 0x0305 || status_code == 0x0323) {
+      waiting_for_idle_ = false;
+      last_command_ms_ = now_ms;
+      return ThermostatAction::STANDBY;
+    }
+    if (!heater_active)
+      waiting_for_idle_ = false;
+  }
+  return ThermostatAction::NONE;
+}
+
+// ===================
+// DisplayPresence
+// ===================
+DisplayEvent DisplayPresence::on_frame(uint32_t now_ms) {
+  if (!connected_ || starting_) {
+    // Pause vor der Rückkehr bzw. seit dem Start gehört nicht zum Takt
+    connected_ = true;
+    starting_ = false;
+    last_frame_ms_ = now_ms;
+    return DisplayEvent::CONNECTED;
+  }
+  uint32_t gap = now_ms - last_frame_ms_;
+  if (static_cast<int32_t>(gap) < 0)
+    return DisplayEvent::NONE;  // Zeitstempel aus dem Bridge-Task leicht verspätet
+  last_frame_ms_ = now_ms;
+  gaps_[gap_next_] = gap;
+  gap_next_ = static_cast<uint8_t>((gap_next_ + 1) % WINDOW);
+  if (gap_count_ < WINDOW)
+    gap_count_++;
+  return DisplayEvent::NONE;
+}
+
+DisplayEvent DisplayPresence::poll(uint32_t now_ms) {
+  if (!connected_)
+    return DisplayEvent::NONE;
+  uint32_t silence = now_ms - last_frame_ms_;
+  if (static_cast<int32_t>(silence) < 0 || silence < timeout_ms())
+    return DisplayEvent::NONE;
+  connected_ = false;
+  if (starting_) {
+    starting_ = false;
+    return DisplayEvent::ABSENT;
+  }
+  return DisplayEvent::LOST;
+}
+
+uint32_t DisplayPresence::cadence_ms() const {
+  if (gap_count_ < MIN_SAMPLES)
+    return 0;
+  uint32_t cadence = 0;
+  for (uint8_t i = 0; i < gap_count_; i++)
+    cadence = std::max(cadence, gaps_[i]);
+  return cadence;
+}
+
+uint32_t DisplayPresence::timeout_ms() const {
+  uint32_t cadence = cadence_ms();
+  if (cadence == 0)
+    return max_timeout_ms_;
+  uint32_t timeout = cadence * missed_frames_ + cadence / 2;
+  return std::min(std::max(timeout, MIN_TIMEOUT_MS), max_timeout_ms_);
+}
+
+// ===================
+// PollScheduler
+// ===================
+PollPhase poll_phase_for_status(uint16_t status_code) {
+  switch (status_code) {
+    case 0x0000:
+    case 0x0001:
+      return POLL_PHASE_STANDBY;
+    case 0x0200:
+    case 0x0201:
+    case 0x0202:
+    case 0x0203:
+    case 0x0204:
+      return POLL_PHASE_STARTUP;
+    case 0x0100:
+    case 0x0304:
+    case 0x0305:
+    case 0x0400:
+      return POLL_PHASE_SHUTDOWN;
+    default:
+      // Heizen, Lüften und unbekannte Codes im normalen Takt
+      return POLL_PHASE_RUNNING;
+  }
+}
+
+void PollScheduler::set_interval(PollPhase phase, uint32_t interval_ms) {
+  if (phase < POLL_PHASE_COUNT && interval_ms > 0)
+    intervals_[phase] = interval_ms;
+}
+
+void PollScheduler::restart(uint32_t now_ms) {
+  next_status_ms_ = now_ms;
+  next_settings_ms_ = now_ms + settings_refresh_ms_;
+}
+
+void PollScheduler::on_status(uint16_t status_code, uint32_t now_ms) {
+  PollPhase phase = poll_phase_for_status(status_code);
+  if (phase == phase_)
+    return;
+  phase_ = phase;
+  // Neues Intervall gilt ab der letzten Abfrage, eine schnellere Phase greift sofort
+  uint32_t next = last_status_request_ms_ + intervals_[phase];
+  next_status_ms_ = earlier_(next, now_ms) ? now_ms : next;
+}
+
+void PollScheduler::on_settings(uint32_t now_ms) { next_settings_ms_ = now_ms + settings_refresh_ms_; }
+
+void PollScheduler::on_frame_sent(const uint8_t *frame, size_t length, uint32_t now_ms) {
+  if (length < FRAME_OVERHEAD)
+    return;
+  uint8_t command = frame[4];
+  if (is_request_frame(frame, length)) {
+    if (command == CMD_STATUS) {
+      last_status_request_ms_ = now_ms;
+      next_status_ms_ = now_ms + intervals_[phase_];
+    } else if (command == CMD_SETTINGS) {
+      next_settings_ms_ = now_ms + settings_refresh_ms_;
+    }
+    return;
+  }
+  uint32_t status_at = now_ms + STATUS_AFTER_COMMAND_MS;
+  if (earlier_(status_at, next_status_ms_))
+    next_status_ms_ = status_at;
+  // Settings setzen beantwortet die Heizung selbst mit den neuen Settings
+  if (command == CMD_SETTINGS)
+    return;
+  uint32_t settings_at = now_ms + SETTINGS_AFTER_COMMAND_MS;
+  if (earlier_(settings_at, next_settings_ms_))
+    next_settings_ms_ = settings_at;
+}
+
+}  // namespace autoterm
@@ -0,0 +1,1343 @@
+#pragma once
+// ===================
+// Autoterm Protokoll-Kern
+// ===================
+// Framing, CRC, Dekodierung und Kommando-Encoder ohne ESPHome-Abhängigkeiten.
+// Lässt sich auch auf einem Linux-Host übersetzen:
+//   g++ -std=c++17 -O2 -c autoterm_protocol.cpp && ar rcs libautoterm_protocol.a autoterm_protocol.o
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(AUTOTERM_UART_CRC_TABLE_IN_RAM) && defined(ESP_PLATFORM)
+#include <esp_attr.h>
+#endif
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+namespace autoterm {
+
+static constexpr uint8_t FRAME_START = 0xAA;
+static constexpr uint8_t DEVICE_CONTROLLER = 0x03;  // Anfrage an die Heizung (Display/ESP)
+static constexpr uint8_t DEVICE_HEATER = 0x04;      // Antwort der Heizung
+static constexpr size_t FRAME_HEADER_LENGTH = 5;
+static constexpr size_t FRAME_CRC_LENGTH = 2;
+static constexpr size_t FRAME_OVERHEAD = FRAME_HEADER_LENGTH + FRAME_CRC_LENGTH;
+// Größter Frame laut Protokoll: 5 Byte Header + 255 Byte Payload + 2 Byte CRC
+static constexpr size_t MAX_FRAME_LENGTH = FRAME_OVERHEAD + 255;
+
+enum Command : uint8_t {
+  CMD_START = 0x01,
+  CMD_SETTINGS = 0x02,  // Settings lesen (ohne Payload) bzw. setzen
+  CMD_STANDBY = 0x03,
+  CMD_STATUS = 0x0F,
+  CMD_PANEL_TEMPERATURE = 0x11,
+  CMD_FAN_ONLY = 0x23,
+};
+
+// ===================
+// CRC16 (Modbus), tabellengesteuert
+// ===================
+// Die Tabelle wird zur Compile-Zeit erzeugt. Standardmäßig liegt sie im Flash,
+// mit crc_table: ram (AUTOTERM_UART_CRC_TABLE_IN_RAM) im internen DRAM.
+static constexpr uint16_t CRC16_MODBUS_INIT = 0xFFFF;
+
+constexpr uint16_t crc16_modbus_bitwise_update(uint16_t crc, uint8_t byte) {
+  crc ^= byte;
+  for (int i = 0; i < 8; i++)
+    crc = (crc & 0x0001) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+  return crc;
+}
+
+struct Crc16ModbusTable {
+  uint16_t entries[256];
+};
+
+constexpr Crc16ModbusTable make_crc16_modbus_table() {
+  Crc16ModbusTable table{};
+  for (int i = 0; i < 256; i++)
+    table.entries[i] = crc16_modbus_bitwise_update(0, static_cast<uint8_t>(i));
+  return table;
+}
+
+#ifdef AUTOTERM_UART_CRC_TABLE_IN_RAM
+static const Crc16ModbusTable CRC16_MODBUS_TABLE DRAM_ATTR = make_crc16_modbus_table();
+#else
+static constexpr Crc16ModbusTable CRC16_MODBUS_TABLE = make_crc16_modbus_table();
+#endif
+
+inline uint16_t crc16_modbus_update(uint16_t crc, uint8_t byte) {
+  return static_cast<uint16_t>((crc >> 8) ^ CRC16_MODBUS_TABLE.entries[(crc ^ byte) & 0xFF]);
+}
+
+inline uint16_t crc16_modbus(const uint8_t *data, size_t length) {
+  uint16_t crc = CRC16_MODBUS_INIT;
+  for (size_t i = 0; i < length; i++)
+    crc = crc16_modbus_update(crc, data[i]);
+  return crc;
+}
+
+// Korrigiert eine CRC, nachdem ein Byte geändert wurde. Die CRC ist linear:
+// crc(a) ^ crc(b) = crc_0(a ^ b), daher genügt die Differenz des Bytes,
+// gefolgt von den restlichen (unveränderten) Bytes als Nullen.
+inline uint16_t crc16_modbus_patch(uint16_t crc, uint8_t old_byte, uint8_t new_byte, size_t trailing_bytes) {
+  uint16_t delta = crc16_modbus_update(0, static_cast<uint8_t>(old_byte ^ new_byte));
+  for (size_t i = 0; i < trailing_bytes; i++)
+    delta = crc16_modbus_update(delta, 0);
+  return static_cast<uint16_t>(crc ^ delta);
+}
+
+// Fortlaufende CRC für byteweise eintreffende Daten
+class Crc16Modbus {
+ public:
+  void reset() { value_ = CRC16_MODBUS_INIT; }
+  void update(uint8_t byte) { value_ = crc16_modbus_update(value_, byte); }
+  uint16_t value() const { return value_; }
+
+ protected:
+  uint16_t value_{CRC16_MODBUS_INIT};
+};
+
+// ===================
+// Lock-freie Hilfstypen
+// ===================
+// Zähler mit genau einem schreibenden Kontext, aus jedem anderen Kontext ohne
+// Lock lesbar. Bewusst kein fetch_add: der ESP8266 hat keine atomaren RMW-Befehle.
+class RelaxedCounter {
+ public:
+  void add(uint32_t n = 1) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+  uint32_t get() const { return value_.load(std::memory_order_relaxed); }
+  // Für Momentanwerte (z. B. letzte Latenz)
+  void set(uint32_t value) { value_.store(value, std::memory_order_relaxed); }
+  // Für Höchststände (z. B. Füllstand einer Queue)
+  void raise_to(uint32_t value) {
+    if (value > get())
+      value_.store(value, std::memory_order_relaxed);
+  }
+
+ protected:
+  std::atomic<uint32_t> value_{0};
+};
+
+// Lock-freie Queue für genau einen Erzeuger und einen Verbraucher (z. B. Task →
+// Hauptloop). Nutzbar sind Capacity - 1 Einträge.
+template<typename T, size_t Capacity> class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity muss eine Zweierpotenz sein");
+
+ public:
+  // Nur vom Erzeuger
+  bool push(const T &item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t next = (head + 1) & MASK;
+    if (next == tail_.load(std::memory_order_acquire))
+      return false;
+    items_[head] = item;
+    head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Nur vom Verbraucher; nullptr, wenn leer
+  const T *front() const {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+      return nullptr;
+    return &items_[tail];
+  }
+  void pop() { tail_.store((tail_.load(std::memory_order_relaxed) + 1) & MASK, std::memory_order_release); }
+
+  bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+ protected:
+  static constexpr uint32_t MASK = Capacity - 1;
+
+  T items_[Capacity]{};
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
+
+// ===================
+// Frame-Assembler (Ringpuffer)
+// ===================
+// Sammelt die Bytes einer Richtung in einem statisch allokierten Ringpuffer.
+// Header, Länge und Frame-Ende werden erkannt, ohne Daten zu verschieben.
+struct FrameAssemblerStats {
+  RelaxedCounter frames;
+  RelaxedCounter bytes;
+  RelaxedCounter passthrough_bytes;
+  RelaxedCounter overflow_bytes;  // Bytes verworfener Kandidaten, roh durchgereicht
+  RelaxedCounter resyncs;         // Startbyte nach losen Bytes oder verworfenem Kandidaten wiedergefunden
+  RelaxedCounter false_starts;    // Kandidat verworfen (Header unplausibel oder CRC falsch mit neuem Startbyte darin)
+  RelaxedCounter gap_flushes;     // angefangener Frame nach Leitungspause verworfen
+};
+
+// Größte plausible Nutzdatenlänge; längere "Frames" sind Störungen mit 0xAA davor
+static constexpr size_t MAX_PLAUSIBLE_PAYLOAD = 32;
+
+// Erwartete Nutzdatenlänge je Funktionscode (Anfrage ohne Nutzdaten oder Antwort/Kommando)
+constexpr bool payload_length_plausible(uint8_t command, uint8_t length) {
+  switch (command) {
+    case CMD_STATUS: return length == 0 || (length >= 17 && length <= MAX_PLAUSIBLE_PAYLOAD);
+    case CMD_SETTINGS:
+    case CMD_START: return length == 0 || length == 6;
+    case CMD_STANDBY: return length == 0;
+    case CMD_PANEL_TEMPERATURE: return length == 1;
+    case CMD_FAN_ONLY: return length == 0 || length == 4;
+    default: return length <= MAX_PLAUSIBLE_PAYLOAD;
+  }
+}
+
+// Setzt Frames aus dem Bytestrom zusammen. Ein 0xAA ist nur ein Kandidat: Gerät
+// (0x03/0x04), Länge je Funktionscode und CRC werden geprüft, sobald die Bytes
+// da sind. Fällt ein Kandidat durch, meldet push() RESYNC: der Aufrufer gibt die
+// ersten skip_length() Bytes mit pop() roh weiter und ruft resume(), das ab dem
+// nächsten 0xAA im Puffer weitermacht. Es geht dabei kein Byte verloren.
+template<size_t Capacity> class FrameAssembler {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity muss eine Zweierpotenz sein");
+
+ public:
+  static constexpr size_t MAX_ASSEMBLED_FRAME = FRAME_OVERHEAD + MAX_PLAUSIBLE_PAYLOAD;
+  static_assert(Capacity >= MAX_ASSEMBLED_FRAME, "Capacity zu klein für den längsten plausiblen Frame");
+
+  enum class Result : uint8_t {
+    PENDING,      // Byte gepuffert, Frame noch unvollständig
+    PASSTHROUGH,  // loses Byte vor einem Header, direkt weiterleiten
+    FRAME,        // vollständiger Frame liegt ab Index 0 im Puffer
+    RESYNC,       // Kandidat verworfen: skip_length() Bytes roh weiterleiten, dann resume()
+  };
+
+  Result push(uint8_t b) {
+    stats_.bytes.add();
+    if (count_ == 0) {
+      if (b != FRAME_START) {
+        stats_.passthrough_bytes.add();
+        out_of_sync_ = true;
+        return Result::PASSTHROUGH;
+      }
+      if (out_of_sync_) {
+        stats_.resyncs.add();
+        out_of_sync_ = false;
+      }
+      crc_.reset();
+    }
+
+    buffer_[(head_ + count_) & MASK] = b;
+    count_++;
+
+    // CRC läuft mit, bis die beiden CRC-Bytes selbst erreicht sind
+    size_t total = frame_length();
+    if (count_ <= 3 || count_ <= total - FRAME_CRC_LENGTH)
+      crc_.update(b);
+
+    // Header-Bytes einzeln prüfen, danach nur noch auf das Frame-Ende warten
+    if (count_ <= FRAME_HEADER_LENGTH && !header_plausible_())
+      return reject_();
+    return check_complete_();
+  }
+
+  // Nach RESYNC bzw. FRAME mit Restbytes: Puffer ab dem Anfang neu bewerten
+  Result resume() {
+    if (count_ == 0)
+      return Result::PENDING;
+    if ((*this)[0] != FRAME_START) {
+      skip_length_ = next_candidate_(0);
+      stats_.passthrough_bytes.add(static_cast<uint32_t>(skip_length_));
+      out_of_sync_ = true;
+      return Result::RESYNC;
+    }
+    stats_.resyncs.add();
+    out_of_sync_ = false;
+    crc_.reset();
+    size_t total = frame_length();
+    for (size_t i = 0; i < count_; i++) {
+      if (i < 3 || i < total - FRAME_CRC_LENGTH)
+        crc_.update((*this)[i]);
+    }
+    if (!header_plausible_())
+      return reject_();
+    return check_complete_();
+  }
+
+  // Leitung war länger still, als ein Frame Pausen haben darf: der angefangene
+  // Frame kommt nicht mehr. Liefert die Anzahl roh weiterzugebender Bytes.
+  size_t flush_partial() {
+    if (count_ == 0)
+      return 0;
+    stats_.gap_flushes.add();
+    stats_.overflow_bytes.add(static_cast<uint32_t>(count_));
+    out_of_sync_ = true;
+    return count_;
+  }
+
+  // Gesamtlänge des Frames am Pufferanfang (Header + Payload + CRC)
+  size_t frame_length() const { return count_ >= 3 ? FRAME_OVERHEAD + static_cast<size_t>((*this)[2]) : 0; }
+  size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  // Ergebnis der mitlaufenden CRC-Prüfung, gültig nach Result::FRAME
+  bool frame_crc_valid() const { return crc_valid_; }
+  // Nach Result::RESYNC: Bytes bis zum nächsten Kandidaten
+  size_t skip_length() const { return skip_length_; }
+  uint8_t operator[](size_t index) const { return buffer_[(head_ + index) & MASK]; }
+
+  void copy_to(uint8_t *out, size_t length) const {
+    for (size_t i = 0; i < length; i++)
+      out[i] = (*this)[i];
+  }
+
+  bool pop(uint8_t *b) {
+    if (count_ == 0)
+      return false;
+    *b = buffer_[head_];
+    discard(1);
+    return true;
+  }
+
+  void discard(size_t length) {
+    if (length > count_)
+      length = count_;
+    head_ = (head_ + length) & MASK;
+    count_ -= length;
+  }
+
+  void clear() {
+    head_ = 0;
+    count_ = 0;
+  }
+
+  const FrameAssemblerStats &stats() const { return stats_; }
+
+ protected:
+  static constexpr size_t MASK = Capacity - 1;
+
+  bool header_plausible_() const {
+    if (count_ >= 2 && (*this)[1] != DEVICE_CONTROLLER && (*this)[1] != DEVICE_HEATER)
+      return false;
+    if (count_ >= 3 && (*this)[2] > MAX_PLAUSIBLE_PAYLOAD)
+      return false;
+    if (count_ >= 4 && (*this)[3] != 0x00)
+      return false;
+    if (count_ >= 5 && !payload_length_plausible((*this)[4], (*this)[2]))
+      return false;
+    return true;
+  }
+
+  Result check_complete_() {
+    size_t total = frame_length();
+    if (count_ < 3 || count_ < total)
+      return Result::PENDING;
+    uint16_t received = static_cast<uint16_t>(((*this)[total - 2] << 8) | (*this)[total - 1]);
+    crc_valid_ = crc_.value() == received;
+    // Falsche CRC und ein weiteres Startbyte im Frame: eher ein Störbyte mit 0xAA
+    // vor einem echten Frame als ein beschädigter Frame
+    if (!crc_valid_ && next_candidate_(1) < total)
+      return reject_();
+    stats_.frames.add();
+    return Result::FRAME;
+  }
+
+  Result reject_() {
+    stats_.false_starts.add();
+    skip_length_ = next_candidate_(1);
+    stats_.overflow_bytes.add(static_cast<uint32_t>(skip_length_));
+    out_of_sync_ = true;
+    return Result::RESYNC;
+  }
+
+  size_t next_candidate_(size_t from) const {
+    for (size_t i = from; i < count_; i++) {
+      if ((*this)[i] == FRAME_START)
+        return i;
+    }
+    return count_;
+  }
+
+  uint8_t buffer_[Capacity]{};
+  size_t head_{0};
+  size_t count_{0};
+  size_t skip_length_{0};
+  Crc16Modbus crc_;
+  bool crc_valid_{false};
+  bool out_of_sync_{false};
+  FrameAssemblerStats stats_{};
+};
+
+using BridgeFrameAssembler = FrameAssembler<128>;
+
+// ===================
+// Histogramm
+// ===================
+// Feste Buckets, der letzte Bucket nimmt alle größeren Werte auf. percentile()
+// liefert die Obergrenze des Buckets, in dem das Perzentil liegt, im letzten
+// Bucket das exakte Maximum.
+template<size_t Buckets> class HistogramCounts {
+  static_assert(Buckets > 1, "mindestens zwei Buckets");
+
+ public:
+  void reset() {
+    std::fill(buckets_, buckets_ + Buckets, 0);
+    count_ = 0;
+    total_ = 0;
+    min_ = 0;
+    max_ = 0;
+  }
+
+  uint32_t count() const { return count_; }
+  uint32_t min() const { return min_; }
+  uint32_t max() const { return max_; }
+  uint32_t average() const { return count_ == 0 ? 0 : static_cast<uint32_t>(total_ / count_); }
+
+ protected:
+  void record_(size_t bucket, uint32_t value) {
+    buckets_[bucket < Buckets ? bucket : Buckets - 1]++;
+    if (count_ == 0 || value < min_)
+      min_ = value;
+    if (value > max_)
+      max_ = value;
+    count_++;
+    total_ += value;
+  }
+
+  // Bucket, in dem das Perzentil liegt; der letzte ist der Überlauf
+  size_t percentile_bucket_(uint8_t percent) const {
+    uint32_t rank = static_cast<uint32_t>((static_cast<uint64_t>(count_) * percent + 99) / 100);
+    uint32_t seen = 0;
+    for (size_t i = 0; i < Buckets; i++) {
+      seen += buckets_[i];
+      if (seen >= rank)
+        return i;
+    }
+    return Buckets - 1;
+  }
+
+  uint32_t buckets_[Buckets]{};
+  uint32_t count_{0};
+  uint64_t total_{0};
+  uint32_t min_{0};
+  uint32_t max_{0};
+};
+
+// Buckets gleicher Breite
+template<size_t Buckets, uint32_t BucketWidth> class Histogram : public HistogramCounts<Buckets> {
+  static_assert(BucketWidth > 0, "BucketWidth muss größer 0 sein");
+
+ public:
+  void add(uint32_t value) { this->record_(value / BucketWidth, value); }
+
+  uint32_t percentile(uint8_t percent) const {
+    if (this->count_ == 0)
+      return 0;
+    size_t bucket = this->percentile_bucket_(percent);
+    if (bucket == Buckets - 1)
+      return this->max_;
+    return std::min<uint32_t>(static_cast<uint32_t>(bucket + 1) * BucketWidth, this->max_);
+  }
+};
+
+// Logarithmische Buckets: 0..3 einzeln, darüber vier je Zweierpotenz (höchstens
+// 25 % Bucketbreite). 64 Buckets reichen bis 131071.
+template<size_t Buckets> class LogHistogram : public HistogramCounts<Buckets> {
+ public:
+  static constexpr size_t bucket_for(uint32_t value) {
+    if (value < 4)
+      return value;
+    uint32_t msb = 31 - static_cast<uint32_t>(__builtin_clz(value));
+    return 4 + (msb - 2) * 4 + ((value >> (msb - 2)) & 3);
+  }
+  // Kleinster Wert, der nicht mehr in den Bucket fällt
+  static constexpr uint32_t upper_bound(size_t bucket) {
+    if (bucket < 4)
+      return static_cast<uint32_t>(bucket) + 1;
+    return static_cast<uint32_t>(5 + (bucket - 4) % 4) << ((bucket - 4) / 4);
+  }
+
+  void add(uint32_t value) { this->record_(bucket_for(value), value); }
+
+  uint32_t percentile(uint8_t percent) const {
+    if (this->count_ == 0)
+      return 0;
+    size_t bucket = this->percentile_bucket_(percent);
+    if (bucket == Buckets - 1)
+      return this->max_;
+    return std::min<uint32_t>(upper_bound(bucket) - 1, this->max_);
+  }
+};
+
+static_assert(LogHistogram<64>::bucket_for(131071) == 63, "64 Log-Buckets reichen bis 131 ms in µs");
+
+// ===================
+// Bridge-Kanal (eine Übertragungsrichtung)
+// ===================
+// Zeit vom Eintreffen des Startbytes bis zu dessen Weiterleitung
+// Nur die Weiterleitung schreibt (ggf. im Bridge-Task). Die 64-Bit-Summe bleibt
+// beim Schreiber, der Mittelwert wird als eigener Zähler lock-frei veröffentlicht.
+class ForwardLatencyStats {
+ public:
+  void add(uint32_t us) {
+    total_us_ += us;
+    uint32_t count = count_.get() + 1;
+    last_us_.set(us);
+    max_us_.raise_to(us);
+    average_us_.set(static_cast<uint32_t>(total_us_ / count));
+    count_.set(count);
+  }
+
+  uint32_t count() const { return count_.get(); }
+  uint32_t last_us() const { return last_us_.get(); }
+  uint32_t max_us() const { return max_us_.get(); }
+  uint32_t average_us() const { return average_us_.get(); }
+
+ protected:
+  uint64_t total_us_{0};
+  RelaxedCounter count_;
+  RelaxedCounter last_us_;
+  RelaxedCounter max_us_;
+  RelaxedCounter average_us_;
+};
+
+// Ziel der weitergeleiteten Bytes (z. B. ein UART)
+class ByteSink {
+ public:
+  virtual void write(const uint8_t *data, size_t length) = 0;
+  // Nach jedem vollständig zurückgehaltenen Frame aufgerufen
+  virtual void frame_complete() {}
+
+ protected:
+  ~ByteSink() = default;
+};
+
+// ===================
+// Sendewarteschlange
+// ===================
+// Nicht blockierende TX-Queue pro UART. service() schreibt nur so viele Bytes
+// in den Treiber, wie in dessen Hardware-FIFO noch Platz haben. Das Sendeende
+// wird aus der Baudrate geschätzt, statt mit flush() darauf zu warten.
+struct TxQueueStats {
+  RelaxedCounter bytes_written;
+  RelaxedCounter dropped_bytes;
+  RelaxedCounter high_water;
+  RelaxedCounter depth;  // Füllstand für Leser auf dem anderen Kern
+};
+
+template<size_t Capacity> class TxQueue : public ByteSink {
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity muss eine Zweierpotenz sein");
+
+ public:
+  // Hardware-FIFO des ESP32/ESP8266-UART
+  static constexpr size_t HARDWARE_FIFO = 128;
+
+  void set_baud_rate(uint32_t baud_rate) {
+    if (baud_rate > 0)
+      byte_time_us_ = (10 * 1000000UL + baud_rate - 1) / baud_rate;  // 8N1
+  }
+
+  // Übernimmt alle Bytes oder keines, damit nie ein halber Frame gesendet wird
+  bool enqueue(const uint8_t *data, size_t length) {
+    if (length > Capacity - count_) {
+      stats_.dropped_bytes.add(static_cast<uint32_t>(length));
+      return false;
+    }
+    for (size_t i = 0; i < length; i++)
+      buffer_[(head_ + count_ + i) & MASK] = data[i];
+    count_ += length;
+    stats_.depth.set(static_cast<uint32_t>(count_));
+    stats_.high_water.raise_to(static_cast<uint32_t>(count_));
+    return true;
+  }
+
+  void write(const uint8_t *data, size_t length) override { enqueue(data, length); }
+
+  // Gibt wartende Bytes an den Treiber, ohne auf die Übertragung zu warten
+  void service(uint32_t now_us, ByteSink &driver) {
+    if (count_ == 0)
+      return;
+    size_t in_fifo = fifo_level(now_us);
+    if (in_fifo >= HARDWARE_FIFO)
+      return;
+    size_t budget = HARDWARE_FIFO - in_fifo;
+    if (budget > count_)
+      budget = count_;
+
+    // Höchstens zwei zusammenhängende Stücke (Umbruch im Ring)
+    size_t first = Capacity - head_;
+    if (first > budget)
+      first = budget;
+    driver.write(&buffer_[head_], first);
+    if (budget > first)
+      driver.write(&buffer_[0], budget - first);
+
+    head_ = (head_ + budget) & MASK;
+    count_ -= budget;
+    stats_.depth.set(static_cast<uint32_t>(count_));
+    stats_.bytes_written.add(static_cast<uint32_t>(budget));
+
+    uint32_t start = static_cast<int32_t>(wire_free_at_us_ - now_us) > 0 ? wire_free_at_us_ : now_us;
+    wire_free_at_us_ = start + static_cast<uint32_t>(budget) * byte_time_us_;
+  }
+
+  // Geschätzte Bytes, die noch im Hardware-FIFO bzw. auf der Leitung sind
+  size_t fifo_level(uint32_t now_us) const {
+    int32_t remaining = static_cast<int32_t>(wire_free_at_us_ - now_us);
+    if (remaining <= 0)
+      return 0;
+    return (static_cast<uint32_t>(remaining) + byte_time_us_ - 1) / byte_time_us_;
+  }
+
+  // true, sobald alle Bytes (geschätzt) vollständig gesendet wurden
+  bool tx_complete(uint32_t now_us) const { return count_ == 0 && fifo_level(now_us) == 0; }
+  // Nur im schreibenden Kontext; andere lesen stats().depth
+  size_t depth() const { return count_; }
+  uint32_t byte_time_us() const { return byte_time_us_; }
+  const TxQueueStats &stats() const { return stats_; }
+
+ protected:
+  static constexpr size_t MASK = Capacity - 1;
+
+  uint8_t buffer_[Capacity]{};
+  size_t head_{0};
+  size_t count_{0};
+  uint32_t byte_time_us_{1042};  // 9600 Baud
+  uint32_t wire_free_at_us_{0};
+  TxQueueStats stats_{};
+};
+
+class BridgeChannel;
+
+// Funktionscodes mit eigenem Frame-Zähler, alles andere landet in COMMAND_SLOT_OTHER
+static constexpr uint8_t TRACKED_COMMANDS[] = {CMD_START,  CMD_SETTINGS,          CMD_STANDBY,
+                                               CMD_STATUS, CMD_PANEL_TEMPERATURE, CMD_FAN_ONLY};
+static constexpr size_t COMMAND_SLOT_OTHER = sizeof(TRACKED_COMMANDS);
+
+inline size_t command_slot(uint8_t command) {
+  for (size_t i = 0; i < sizeof(TRACKED_COMMANDS); i++) {
+    if (TRACKED_COMMANDS[i] == command)
+      return i;
+  }
+  return COMMAND_SLOT_OTHER;
+}
+
+// Zustandszähler eines Bridge-Kanals zusätzlich zu den Assembler-Statistiken
+struct ChannelTelemetry {
+  RelaxedCounter crc_errors;
+  RelaxedCounter rewritten;
+  RelaxedCounter injected;  // eigene Frames auf der Zielleitung dieses Kanals
+  RelaxedCounter commands[COMMAND_SLOT_OTHER + 1];
+};
+
+class BridgeChannelListener {
+ public:
+  // Kann ein Frame mit diesem Header umgeschrieben werden? Dann wird er bis zum CRC gehalten.
+  virtual bool may_rewrite_frame(const BridgeChannel &channel, uint8_t device, uint8_t command) = 0;
+  // Umschreiben eines gehaltenen, CRC-gültigen Frames vor der Weiterleitung; true bei Änderung
+  virtual bool rewrite_frame(const BridgeChannel &channel, uint8_t *frame, size_t length) = 0;
+  // Nach der Weiterleitung eines vollständigen Frames
+  virtual void on_frame(const BridgeChannel &channel, const uint8_t *frame, size_t length, bool crc_valid) = 0;
+
+ protected:
+  ~BridgeChannelListener() = default;
+};
+
+class BridgeChannel {
+ public:
+  BridgeChannel(const char *tag, bool from_display) : tag_(tag), from_display_(from_display) {}
+
+  void set_cut_through(bool enabled) { cut_through_ = enabled; }
+  bool cut_through() const { return cut_through_; }
+
+  // Pause in Zeichenzeiten (8N1), ab der ein angefangener Frame als abgebrochen
+  // gilt. Sender schicken einen Frame am Stück. Der ESP-IDF-Treiber meldet den
+  // Rest eines Frames aber erst nach seinem RX-Timeout (Standard 10 Zeichen),
+  // daher 15 Zeichen. Der nächste Frame des Bedienteils (~2 s) bleibt weit weg.
+  static constexpr uint32_t FRAME_GAP_CHARACTERS = 15;
+  static constexpr uint32_t DEFAULT_FRAME_GAP_US = FRAME_GAP_CHARACTERS * 10 * 1000000UL / 9600;
+
+  // Verarbeitet ein empfangenes Byte und leitet es (ggf. verzögert) an sink weiter
+  void push(uint8_t b, uint32_t now_us, ByteSink &sink, BridgeChannelListener &listener);
+  // Verarbeitet einen am Stück gelesenen Block (z. B. aus read_array), gleiche Zeitbasis für alle Bytes
+  void push(const uint8_t *data, size_t length, uint32_t now_us, ByteSink &sink, BridgeChannelListener &listener) {
+    for (size_t i = 0; i < length; i++)
+      push(data[i], now_us, sink, listener);
+  }
+  // Nach dem Leeren des RX-Puffers aufrufen: war die Leitung seit dem letzten Byte
+  // länger als frame_gap_us still, kommt der angefangene Frame nicht mehr und wird
+  // roh weitergegeben. Erst nach dem Leeren, damit blockweises Lesen keine Pause
+  // vortäuscht.
+  void poll_gap(uint32_t now_us, ByteSink &sink);
+  void set_frame_gap_us(uint32_t gap_us) { frame_gap_us_ = gap_us; }
+  // Pause aus der Baudrate der Quellleitung ableiten
+  void set_baud_rate(uint32_t baud_rate) {
+    if (baud_rate > 0)
+      frame_gap_us_ = static_cast<uint32_t>(FRAME_GAP_CHARACTERS * 10 * 1000000ULL / baud_rate);
+  }
+
+  const char *tag() const { return tag_; }
+  bool from_display() const { return from_display_; }
+  // Kein angefangener Frame im Puffer
+  bool idle() const { return assembler_.empty(); }
+  const FrameAssemblerStats &stats() const { return assembler_.stats(); }
+  const ForwardLatencyStats &latency() const { return latency_; }
+  const ChannelTelemetry &telemetry() const { return telemetry_; }
+  // Für eigene Frames, die der Aufrufer auf die Zielleitung dieses Kanals legt
+  void count_injected() { telemetry_.injected.add(); }
+
+ protected:
+  void cut_through_pending_(uint32_t now_us, ByteSink &sink, BridgeChannelListener &listener);
+  void forward_buffered_(ByteSink &sink, size_t end);
+  void release_(size_t length, ByteSink &sink);
+  void reset_frame_();
+  void note_start_byte_(uint32_t now_us);
+  // Ankunftszeit des Bytes am Pufferanfang, falls es als Startbyte vermerkt ist
+  uint32_t candidate_start_us_(uint32_t fallback_us) const;
+
+  // Ankunftszeiten der letzten Startbytes im Puffer, damit ein nach einem Resync
+  // gefundener Frame seine echte Startzeit behält
+  struct StartMark {
+    uint32_t position;
+    uint32_t time_us;
+  };
+  static constexpr size_t START_MARKS = 8;
+
+  const char *tag_;
+  bool from_display_;
+  bool cut_through_{false};
+
+  BridgeFrameAssembler assembler_;
+  ForwardLatencyStats latency_;
+  ChannelTelemetry telemetry_;
+  size_t forwarded_{0};     // bereits an sink weitergegebene Bytes des aktuellen Frames
+  bool decided_{false};     // Cut-Through-Entscheidung für den aktuellen Frame getroffen
+  bool hold_{false};        // Frame wird bis zum CRC zurückgehalten
+  uint32_t frame_start_us_{0};
+  uint32_t last_byte_us_{0};
+  uint32_t frame_gap_us_{DEFAULT_FRAME_GAP_US};
+  uint32_t buffered_total_{0};  // Position des Pufferendes seit dem Start
+  StartMark start_marks_[START_MARKS]{};
+  uint8_t start_mark_next_{0};
+  uint8_t frame_[BridgeFrameAssembler::MAX_ASSEMBLED_FRAME]{};
+};
+
+// ===================
+// Trace-Ring
+// ===================
+// Hält Rohbytes mit Zeitstempel fest, damit die Hex-Formatierung nicht im
+// Weiterleitungspfad passiert. Ist der Ring voll, wird der neue Eintrag verworfen.
+enum class TraceKind : uint8_t {
+  FRAME,    // von der Bridge weitergeleiteter Frame (label = Richtung)
+  COMMAND,  // eigenes Kommando an die Heizung (label = Kommandoname)
+};
+
+template<size_t MaxBytes> struct TraceEntry {
+  uint32_t time_ms;
+  const char *label;  // muss statisch sein (String-Literal)
+  TraceKind kind;
+  uint8_t length;     // gespeicherte Bytes
+  uint16_t original_length;
+  uint8_t data[MaxBytes];
+};
+
+template<size_t Entries, size_t MaxBytes> class TraceRing {
+  static_assert((Entries & (Entries - 1)) == 0, "Entries muss eine Zweierpotenz sein");
+  static_assert(MaxBytes <= 255, "MaxBytes passt nicht in length");
+
+ public:
+  using Entry = TraceEntry<MaxBytes>;
+
+  bool record(uint32_t time_ms, TraceKind kind, const char *label, const uint8_t *data, size_t length) {
+    if (write_index_ - read_index_ >= Entries) {
+      dropped_++;
+      return false;
+    }
+    Entry &entry = entries_[write_index_ & MASK];
+    entry.time_ms = time_ms;
+    entry.label = label;
+    entry.kind = kind;
+    entry.original_length = static_cast<uint16_t>(length);
+    entry.length = static_cast<uint8_t>(length < MaxBytes ? length : MaxBytes);
+    for (size_t i = 0; i < entry.length; i++)
+      entry.data[i] = data[i];
+    write_index_++;
+    return true;
+  }
+
+  const Entry *front() const { return empty() ? nullptr : &entries_[read_index_ & MASK]; }
+  void pop_front() {
+    if (!empty())
+      read_index_++;
+  }
+  bool empty() const { return read_index_ == write_index_; }
+  uint32_t dropped() const { return dropped_; }
+
+ protected:
+  static constexpr uint32_t MASK = Entries - 1;
+
+  Entry entries_[Entries]{};
+  uint32_t write_index_{0};
+  uint32_t read_index_{0};
+  uint32_t dropped_{0};
+};
+
+// Schreibt "AA 03 ..." nach out (nullterminiert), liefert die Zeichenanzahl
+size_t format_hex(const uint8_t *data, size_t length, char *out, size_t out_size);
+
+// ===================
+// Dekodierung
+// ===================
+struct Settings {
+  uint8_t use_work_time = 1;
+  uint8_t work_time = 0;
+  uint8_t temperature_source = 4;
+  uint8_t set_temperature = 16;
+  uint8_t wait_mode = 0;
+  uint8_t power_level = 8;
+};
+
+struct Status {
+  uint16_t code{0};
+  float value{0.0f};  // Statuscode als Zahl (z. B. 3.0 für 0x0300)
+  float internal_temp{0.0f};
+  float external_temp{0.0f};
+  float voltage{0.0f};
+  float heater_temp{0.0f};  // NAN, wenn der Sensor 0xFFFF meldet
+  float fan_set_rpm{0.0f};
+  float fan_actual_rpm{0.0f};
+  float pump_frequency{0.0f};
+};
+
+// Nicht besitzende Sicht auf einen vollständigen Frame. Der Header wird einmal
+// geprüft; die typisierten Sichten darunter lesen nur noch die Nutzdaten.
+class FrameView {
+ public:
+  FrameView(const uint8_t *data, size_t length) : data_(data), length_(length) {}
+
+  // Startbyte vorhanden und Länge passt zum Längenbyte
+  bool valid() const {
+    return length_ >= FRAME_OVERHEAD && data_[0] == FRAME_START && length_ == data_[2] + FRAME_OVERHEAD;
+  }
+  uint8_t device() const { return data_[1]; }
+  uint8_t command() const { return data_[4]; }
+  size_t payload_length() const { return length_ - FRAME_OVERHEAD; }
+  const uint8_t *payload() const { return data_ + FRAME_HEADER_LENGTH; }
+  const uint8_t *data() const { return data_; }
+  size_t length() const { return length_; }
+  bool from_heater() const { return data_[1] == DEVICE_HEATER; }
+
+ protected:
+  const uint8_t *data_;
+  size_t length_;
+};
+
+// Statusframe 0x0F der Heizung (AA 04 13 00 0F ...)
+class StatusFrame {
+ public:
+  static constexpr size_t MIN_PAYLOAD = 17;
+  static bool matches(const FrameView &frame) {
+    return frame.from_heater() && frame.command() == CMD_STATUS && frame.payload_length() >= MIN_PAYLOAD;
+  }
+  explicit StatusFrame(const FrameView &frame) : p_(frame.payload()) {}
+
+  uint16_t code() const { return (static_cast<uint16_t>(p_[0]) << 8) | p_[1]; }
+  float internal_temp() const { return p_[3] > 127 ? p_[3] - 255 : p_[3]; }
+  float external_temp() const { return p_[4] > 127 ? p_[4] - 255 : p_[4]; }
+  float voltage() const { return p_[6] / 10.0f; }
+  // NAN, wenn der Sensor 0xFFFF meldet
+  float heater_temp() const;
+  float fan_set_rpm() const { return p_[11] * 60.0f; }
+  float fan_actual_rpm() const { return p_[12] * 60.0f; }
+  float pump_frequency() const { return p_[14] / 100.0f; }
+  void decode(Status &out) const;
+
+ protected:
+  const uint8_t *p_;
+};
+
+// Settingsframe 0x02 der Heizung (AA 04 06 00 02 ...)
+class SettingsFrame {
+ public:
+  static constexpr size_t PAYLOAD = 6;
+  static bool matches(const FrameView &frame) {
+    return frame.from_heater() && frame.command() == CMD_SETTINGS && frame.payload_length() >= PAYLOAD;
+  }
+  explicit SettingsFrame(const FrameView &frame) : p_(frame.payload()) {}
+
+  uint8_t temperature_source() const { return p_[2]; }
+  uint8_t set_temperature() const { return p_[3]; }
+  uint8_t power_level() const { return p_[5]; }
+  void decode(Settings &out) const {
+    out.use_work_time = p_[0];
+    out.work_time = p_[1];
+    out.temperature_source = p_[2];
+    out.set_temperature = p_[3];
+    out.wait_mode = p_[4];
+    out.power_level = p_[5];
+  }
+
+ protected:
+  const uint8_t *p_;
+};
+
+// Panel-Temperatur 0x11 in beiden Richtungen (AA 03|04 01 00 11 <temp>)
+class PanelTempFrame {
+ public:
+  static constexpr size_t TEMPERATURE_INDEX = FRAME_HEADER_LENGTH;
+  static bool matches(const FrameView &frame) {
+    return (frame.device() == DEVICE_CONTROLLER || frame.device() == DEVICE_HEATER) &&
+           frame.command() == CMD_PANEL_TEMPERATURE && frame.payload_length() == 1 && frame.data()[3] == 0x00;
+  }
+  explicit PanelTempFrame(const FrameView &frame) : p_(frame.payload()) {}
+
+  uint8_t temperature() const { return p_[0]; }
+
+ protected:
+  const uint8_t *p_;
+};
+
+// Start-/Settings-Kommando des Bedienteils (AA 03 06 00 01|02 ...)
+class CommandFrame {
+ public:
+  static constexpr size_t TEMP_SOURCE_INDEX = FRAME_HEADER_LENGTH + 2;
+  static bool matches(const FrameView &frame) {
+    return frame.device() == DEVICE_CONTROLLER && (frame.command() == CMD_START || frame.command() == CMD_SETTINGS) &&
+           frame.payload_length() >= 3;
+  }
+  explicit CommandFrame(const FrameView &frame) : p_(frame.payload()) {}
+
+  uint8_t temperature_source() const { return p_[2]; }
+
+ protected:
+  const uint8_t *p_;
+};
+
+// Wrapper für Aufrufer mit Rohdaten (z. B. das Replay-Tool)
+bool decode_status(const uint8_t *frame, size_t length, Status &out);
+bool decode_settings(const uint8_t *frame, size_t length, Settings &out);
+bool is_panel_temperature_frame(const uint8_t *frame, size_t length);
+// Klartext bekannter Statuscodes, nullptr für unbekannte Codes
+const char *status_text(uint16_t status_code);
+bool is_heater_active_status(uint16_t status_code);
+
+// Ändert ein Byte eines gültigen Frames und korrigiert die CRC inkrementell
+void patch_frame_byte(uint8_t *frame, size_t length, size_t index, uint8_t value);
+
+// ===================
+// Publish-Filter
+// ===================
+// Entscheidet, ob ein neuer Messwert veröffentlicht wird: bei einer Änderung
+// von mindestens deadband (0 = jede Änderung), beim Wechsel von/zu NaN oder
+// spätestens nach heartbeat_ms Funkstille (0 = kein Heartbeat).
+class PublishFilter {
+ public:
+  void set_deadband(float deadband) { deadband_ = deadband < 0.0f ? 0.0f : deadband; }
+  float deadband() const { return deadband_; }
+
+  bool should_publish(float value, uint32_t now_ms, uint32_t heartbeat_ms) const;
+  // Nach dem Publish aufrufen
+  void mark_published(float value, uint32_t now_ms) {
+    last_value_ = value;
+    last_publish_ms_ = now_ms;
+    published_ = true;
+  }
+
+ protected:
+  float deadband_{0.0f};
+  float last_value_{0.0f};
+  uint32_t last_publish_ms_{0};
+  bool published_{false};
+};
+
+// ===================
+// Kommando-Encoder
+// ===================
+// Frames haben eine feste, von der Nutzdatenlänge abhängige Größe und liegen
+// als std::array auf dem Stack. Kommandos ohne Parameter werden samt CRC zur
+// Compile-Zeit erzeugt, alle anderen zur Laufzeit über die CRC-Tabelle.
+static constexpr size_t MAX_COMMAND_PAYLOAD = 6;
+static constexpr size_t MAX_COMMAND_FRAME_LENGTH = FRAME_OVERHEAD + MAX_COMMAND_PAYLOAD;
+
+template<size_t PayloadLength> using CommandFrameBytes = std::array<uint8_t, FRAME_OVERHEAD + PayloadLength>;
+
+// Header und Nutzdaten, die CRC-Bytes bleiben 0
+template<size_t PayloadLength>
+constexpr CommandFrameBytes<PayloadLength> command_frame_body(uint8_t command,
+                                                              const std::array<uint8_t, PayloadLength> &payload) {
+  static_assert(PayloadLength <= MAX_COMMAND_PAYLOAD, "Nutzdaten zu lang");
+  CommandFrameBytes<PayloadLength> frame{};
+  frame[0] = FRAME_START;
+  frame[1] = DEVICE_CONTROLLER;
+  frame[2] = static_cast<uint8_t>(PayloadLength);
+  frame[3] = 0x00;
+  frame[4] = command;
+  for (size_t i = 0; i < PayloadLength; i++)
+    frame[FRAME_HEADER_LENGTH + i] = payload[i];
+  return frame;
+}
+
+// Für konstante Frames: CRC bitweise, damit sie vollständig zur Compile-Zeit entsteht
+template<size_t PayloadLength>
+constexpr CommandFrameBytes<PayloadLength> constant_command_frame(uint8_t command,
+                                                                  const std::array<uint8_t, PayloadLength> &payload) {
+  CommandFrameBytes<PayloadLength> frame = command_frame_body(command, payload);
+  uint16_t crc = CRC16_MODBUS_INIT;
+  for (size_t i = 0; i < FRAME_HEADER_LENGTH + PayloadLength; i++)
+    crc = crc16_modbus_bitwise_update(crc, frame[i]);
+  frame[FRAME_HEADER_LENGTH + PayloadLength] = static_cast<uint8_t>(crc >> 8);
+  frame[FRAME_HEADER_LENGTH + PayloadLength + 1] = static_cast<uint8_t>(crc & 0xFF);
+  return frame;
+}
+
+template<size_t PayloadLength>
+CommandFrameBytes<PayloadLength> build_command_frame(uint8_t command, const std::array<uint8_t, PayloadLength> &payload) {
+  CommandFrameBytes<PayloadLength> frame = command_frame_body(command, payload);
+  uint16_t crc = crc16_modbus(frame.data(), FRAME_HEADER_LENGTH + PayloadLength);
+  frame[FRAME_HEADER_LENGTH + PayloadLength] = static_cast<uint8_t>(crc >> 8);
+  frame[FRAME_HEADER_LENGTH + PayloadLength + 1] = static_cast<uint8_t>(crc & 0xFF);
+  return frame;
+}
+
+static constexpr CommandFrameBytes<0> STANDBY_FRAME = constant_command_frame<0>(CMD_STANDBY, {});
+static constexpr CommandFrameBytes<0> STATUS_REQUEST_FRAME = constant_command_frame<0>(CMD_STATUS, {});
+static constexpr CommandFrameBytes<0> SETTINGS_REQUEST_FRAME = constant_command_frame<0>(CMD_SETTINGS, {});
+// Abgleich mit mitgeschnittenen Frames (AA 03 00 00 0F 58 7C)
+static_assert(STATUS_REQUEST_FRAME[5] == 0x58 && STATUS_REQUEST_FRAME[6] == 0x7C, "CRC der Statusabfrage");
+static_assert(STANDBY_FRAME[5] == 0x5D && STANDBY_FRAME[6] == 0x7C, "CRC von Standby");
+static_assert(SETTINGS_REQUEST_FRAME[5] == 0x9D && SETTINGS_REQUEST_FRAME[6] == 0xBD, "CRC der Settings-Abfrage");
+
+// Temperaturquelle (1=intern, 2=Panel, 3=extern, 4=Home Assistant) → Sensorbyte der Heizung
+uint8_t map_temp_source_to_heater(uint8_t source);
+
+CommandFrameBytes<6> power_mode_frame(bool start, uint8_t level);
+CommandFrameBytes<6> temperature_hold_mode_frame(bool start, uint8_t heater_sensor, uint8_t set_temp);
+CommandFrameBytes<6> temperature_to_fan_mode_frame(bool start, uint8_t heater_sensor, uint8_t set_temp);
+CommandFrameBytes<4> fan_only_frame(uint8_t level);
+CommandFrameBytes<6> thermostat_cooldown_frame(uint8_t heater_sensor, uint8_t set_temp);
+CommandFrameBytes<1> panel_temperature_frame(uint8_t temperature);
+
+// true, wenn ein 0x02-Set-Kommando nichts an den bestätigten Settings ändert
+// (0xFF im Payload bedeutet "unverändert")
+bool settings_command_is_redundant(const uint8_t *frame, size_t length, const Settings &confirmed);
+
+// Betriebsart, die sich aus bestätigten Settings ablesen lässt
+enum class SettingsMode : uint8_t {
+  UNKNOWN,   // nicht eindeutig, bisherigen Zustand behalten
+  STANDBY,   // wait_mode 0 und Leistungsstufe 0
+  POWER,     // Leistungsmodus (Temperaturquelle 4)
+  HEAT,      // Temperatur halten (wait_mode 2)
+  HEAT_FAN,  // bis zur Solltemperatur heizen, dann lüften (wait_mode 1)
+};
+SettingsMode settings_mode(const Settings &settings);
+
+// ===================
+// Kommando-Scheduler
+// ===================
+// Sammelt Kommandos an die Heizung und gibt sie nur in Buspausen frei: kein
+// halber Frame unterwegs, keine offene Anfrage, Leitung seit IDLE_GAP_MS ruhig.
+// Überholte Kommandos werden zusammengefasst, der letzte Wert gewinnt.
+struct ScheduledCommand {
+  uint8_t frame[MAX_COMMAND_FRAME_LENGTH];
+  uint8_t length;
+  const char *label;
+};
+
+// Abfragen (Status, Settings lesen) haben keinen Payload, Standby ebenfalls
+bool is_request_frame(const uint8_t *frame, size_t length);
+
+struct CommandSchedulerStats {
+  uint32_t submitted{0};
+  uint32_t coalesced{0};
+  uint32_t redundant{0};
+  uint32_t injected{0};
+  uint32_t dropped{0};
+};
+
+class CommandScheduler {
+ public:
+  static constexpr size_t SLOTS = 6;
+  static constexpr uint32_t IDLE_GAP_MS = 15;
+  static constexpr uint32_t RESPONSE_TIMEOUT_MS = 250;
+
+  enum class Submit { QUEUED, COALESCED, REDUNDANT, FULL };
+
+  // confirmed: zuletzt von der Heizung gemeldete Settings oder nullptr
+  Submit submit(const uint8_t *frame, size_t length, const char *label, const Settings *confirmed);
+
+  // Busbeobachtung
+  void note_activity(uint32_t now_ms) {
+    if (static_cast<int32_t>(now_ms - last_activity_ms_) > 0)
+      last_activity_ms_ = now_ms;
+  }
+  void note_request(uint32_t now_ms) {
+    awaiting_response_ = true;
+    request_ms_ = now_ms;
+    last_activity_ms_ = now_ms;
+  }
+  void note_response(uint32_t now_ms) {
+    awaiting_response_ = false;
+    last_activity_ms_ = now_ms;
+  }
+  // Neue Settings der Heizung: gesendete Änderungen sind bestätigt
+  void note_settings_confirmed() { settings_pending_ = false; }
+
+  // line_busy: angefangener Frame oder volle TX-Queue Richtung Heizung
+  bool ready(uint32_t now_ms, bool line_busy) const;
+  // Entnimmt das nächste Kommando; der Aufrufer muss es direkt senden
+  bool pop(uint32_t now_ms, ScheduledCommand &out);
+
+  size_t pending() const { return count_; }
+  // Wartet bereits ein Kommando mit demselben Funktionscode?
+  bool has_pending(const uint8_t *frame, size_t length) const;
+  // Verwirft wartende Abfragen (Bedienteil fragt wieder selbst); liefert die Anzahl
+  size_t drop_requests();
+  const CommandSchedulerStats &stats() const { return stats_; }
+
+ protected:
+  void remove_(size_t index);
+  int find_(uint8_t command, bool request) const;
+
+  ScheduledCommand slots_[SLOTS]{};
+  size_t count_{0};
+  bool awaiting_response_{false};
+  bool settings_pending_{false};  // Modus-Kommando gesendet, noch keine Settings-Antwort
+  uint32_t request_ms_{0};
+  uint32_t last_activity_ms_{0};
+  CommandSchedulerStats stats_{};
+};
+
+// ===================
+// Anfrage/Antwort-Zuordnung
+// ===================
+// Merkt sich pro Funktionscode die offene Anfrage an die Heizung. Die Heizung
+// antwortet mit demselben Funktionscode (AA 04 .. <cmd>), daraus ergibt sich die
+// Antwortzeit. Eigene Abfragen ohne Antwort werden mit wachsendem Timeout
+// (250, 500, 1000 ms) wiederholt und erst danach als Timeout gezählt; eigene
+// Kommandos und Anfragen des Bedienteils werden nur gezählt.
+struct RequestTrackerStats {
+  uint32_t matched{0};
+  uint32_t timeouts{0};
+  uint32_t retries{0};
+  uint32_t unmatched{0};
+};
+
+class RequestTracker {
+ public:
+  static constexpr size_t SLOTS = 4;
+  static constexpr uint32_t BASE_TIMEOUT_MS = 250;
+  static constexpr uint8_t MAX_RETRIES = 2;
+  // 4 ms Buckets bis 252 ms, darüber Sammelbucket
+  using LatencyHistogram = Histogram<64, 4>;
+
+  // sent_ms: Zeitpunkt, an dem das letzte Byte der Anfrage die Leitung verlässt
+  void on_request(const uint8_t *frame, size_t length, uint32_t sent_ms, bool own, const char *label);
+  // Antwortframe der Heizung; false, wenn keine passende Anfrage offen war
+  bool on_response(uint8_t command, uint32_t now_ms);
+  // Liefert die nächste abgelaufene eigene Anfrage, die erneut gesendet werden soll
+  bool poll(uint32_t now_ms, ScheduledCommand &retry);
+  // Gibt den Slot frei, ohne Timeout oder Latenz zu zählen (Wiederholung verworfen)
+  void cancel(uint8_t command);
+  // Gibt alle eigenen Anfragen frei, z. B. wenn das Bedienteil wieder selbst abfragt
+  void cancel_own();
+
+  bool in_flight(uint8_t command) const { return find_(command) >= 0; }
+  const RequestTrackerStats &stats() const { return stats_; }
+  const LatencyHistogram &latency() const { return latency_; }
+  void reset_latency() { latency_.reset(); }
+
+ protected:
+  enum class State : uint8_t { FREE, IN_FLIGHT, RETRY };
+
+  struct Slot {
+    State state{State::FREE};
+    uint8_t command{0};
+    bool own{false};
+    uint8_t attempts{0};
+    uint32_t sent_ms{0};
+    ScheduledCommand request{};
+  };
+
+  int find_(uint8_t command) const;
+  void release_(Slot &slot);
+  static uint32_t timeout_ms_(uint8_t attempts) { return BASE_TIMEOUT_MS << attempts; }
+
+  Slot slots_[SLOTS]{};
+  RequestTrackerStats stats_{};
+  LatencyHistogram latency_;
+};
+
+// ===================
+// Thermostat
+// ===================
+// Zweipunktregelung mit Hysterese über den Heizbetrieb der Heizung:
+// unter target - hys_on wird gestartet, über target + hys_off auf eine niedrige
+// Solltemperatur gedrosselt (Heizen+Lüften), und sobald die Heizung in die
+// Nachlauf-Lüftung geht, folgt Standby. Die Engine entscheidet nur; Senden und
+// Loggen übernimmt der Aufrufer anhand der zurückgegebenen Aktion.
+struct ThermostatConfig {
+  float target_c{20.0f};
+  float hys_on_c{2.0f};
+  float hys_off_c{1.0f};
+  uint8_t level{4};
+};
+
+enum class ThermostatAction : uint8_t {
+  NONE,
+  START,         // Heizung steht: Start mit power_mode_frame(true, level)
+  SET_LEVEL,     // Heizung läuft schon, Anforderung übernommen, neue Stufe senden
+  CLAIM,         // Heizung läuft schon mit passender Stufe, nur Anforderung gesetzt
+  ADJUST_LEVEL,  // Stufe während des Heizens geändert
+  COOLDOWN,      // Obergrenze überschritten: thermostat_cooldown_frame(cooldown_temperature())
+  STANDBY,       // Nachlauf erreicht: Standby senden
+};
+
+class ThermostatEngine {
+ public:
+  static constexpr uint32_t EVALUATION_INTERVAL_MS = 1000;
+  static constexpr uint32_t COMMAND_GUARD_MS = 1000;
+  static constexpr uint32_t LEVEL_ADJUST_GUARD_MS = 1500;
+  static constexpr float COOLDOWN_OFFSET_C = 5.0f;
+  static constexpr uint8_t NO_LEVEL = 255;
+
+  // Aktiviert bzw. ändert die Regelung; liefert ADJUST_LEVEL, wenn während des
+  // Heizens eine neue Stufe gesendet werden muss
+  ThermostatAction configure(const ThermostatConfig &config, uint32_t now_ms);
+  // Aus dem Flash übernommen: Heizanforderung beim ersten Status abgleichen
+  void restore(const ThermostatConfig &config);
+  void deactivate();
+
+  // Periodisch (force = false, höchstens alle EVALUATION_INTERVAL_MS) oder nach
+  // jedem Status; current_c darf NAN sein
+  ThermostatAction evaluate(float current_c, bool heater_running, uint32_t now_ms, bool force);
+  ThermostatAction on_status(uint16_t status_code, uint32_t now_ms);
+
+  bool active() const { return active_; }
+  bool heating_request() const { return heating_request_; }
+  bool waiting_for_idle() const { return waiting_for_idle_; }
+  const ThermostatConfig &config() const { return config_; }
+  // Solltemperatur des Drossel-Kommandos
+  uint8_t cooldown_temperature() const;
+
+ protected:
+  bool command_recent_(uint32_t now_ms) const {
+    return last_command_ms_ != 0 && (now_ms - last_command_ms_) < COMMAND_GUARD_MS;
+  }
+
+  ThermostatConfig config_{};
+  bool active_{false};
+  bool heating_request_{false};
+  bool waiting_for_idle_{false};
+  bool resync_{false};
+  uint8_t last_sent_level_{NO_LEVEL};
+  uint32_t last_command_ms_{0};
+  uint32_t last_evaluation_ms_{0};
+};
+
+// ===================
+// Bedienteil-Erkennung
+// ===================
+// Lernt den Abfragetakt des Bedienteils aus den Abständen seiner Frames und
+// erklärt es für getrennt, sobald missed_frames erwartete Frames ausgeblieben
+// sind (plus ein halber Takt Toleranz). Solange der Takt noch nicht gelernt
+// ist, und als Obergrenze, gilt max_timeout. Nach dem Start gilt das Bedienteil
+// für max_timeout als vorhanden, damit der ESP nicht zwischen dessen Frames sendet.
+enum class DisplayEvent : uint8_t {
+  NONE,
+  CONNECTED,  // erster Frame nach einer Trennung
+  LOST,       // erwartete Frames ausgeblieben
+  ABSENT,     // seit dem Start kein Frame gesehen
+};
+
+class DisplayPresence {
+ public:
+  static constexpr size_t WINDOW = 8;
+  static constexpr uint8_t MIN_SAMPLES = 3;
+  static constexpr uint32_t MIN_TIMEOUT_MS = 250;
+  static constexpr uint32_t DEFAULT_MAX_TIMEOUT_MS = 5000;
+  static constexpr uint8_t DEFAULT_MISSED_FRAMES = 1;
+
+  void set_missed_frames(uint8_t missed) { missed_frames_ = missed > 0 ? missed : 1; }
+  void set_max_timeout(uint32_t timeout_ms) { max_timeout_ms_ = timeout_ms; }
+
+  // Beim Start mit angeschlossener Bedienteil-Leitung: Schonfrist beginnt
+  void start(uint32_t now_ms) {
+    connected_ = true;
+    starting_ = true;
+    last_frame_ms_ = now_ms;
+  }
+  // Jeder Frame des Bedienteils, auch mit falscher CRC; CONNECTED nach einer Trennung
+  DisplayEvent on_frame(uint32_t now_ms);
+  // Periodisch aufrufen; LOST, sobald die erwarteten Frames ausbleiben
+  DisplayEvent poll(uint32_t now_ms);
+
+  bool connected() const { return connected_; }
+  uint32_t last_frame_ms() const { return last_frame_ms_; }
+  // Größter Frame-Abstand im Fenster; 0, solange zu wenige Abstände gesehen wurden
+  uint32_t cadence_ms() const;
+  uint32_t timeout_ms() const;
+
+ protected:
+  uint32_t gaps_[WINDOW]{};
+  uint8_t gap_count_{0};
+  uint8_t gap_next_{0};
+  uint8_t missed_frames_{DEFAULT_MISSED_FRAMES};
+  uint32_t max_timeout_ms_{DEFAULT_MAX_TIMEOUT_MS};
+  bool connected_{false};
+  bool starting_{false};  // Schonfrist nach dem Start, noch kein Frame gesehen
+  uint32_t last_frame_ms_{0};
+};
+
+// ===================
+// Abfrageplan ohne Bedienteil
+// ===================
+// Ohne Bedienteil fragt der Adapter Status und Settings selbst ab. Das
+// Statusintervall richtet sich nach der Betriebsphase der Heizung (Zündung eng
+// verfolgen, Standby selten), Settings werden nach eigenen Kommandos gelesen
+// und sonst nur in einem langen Rückfallintervall aufgefrischt.
+enum PollPhase : uint8_t {
+  POLL_PHASE_STANDBY = 0,
+  POLL_PHASE_STARTUP,
+  POLL_PHASE_RUNNING,
+  POLL_PHASE_SHUTDOWN,
+  POLL_PHASE_COUNT,
+};
+
+PollPhase poll_phase_for_status(uint16_t status_code);
+
+class PollScheduler {
+ public:
+  static constexpr uint32_t DEFAULT_STANDBY_MS = 10000;
+  static constexpr uint32_t DEFAULT_STARTUP_MS = 500;
+  static constexpr uint32_t DEFAULT_RUNNING_MS = 2000;
+  static constexpr uint32_t DEFAULT_SHUTDOWN_MS = 1000;
+  static constexpr uint32_t DEFAULT_SETTINGS_REFRESH_MS = 600000;
+  // Nach einem Kommando: Status zeitnah, Settings erst nach der Übernahme lesen
+  static constexpr uint32_t STATUS_AFTER_COMMAND_MS = 250;
+  static constexpr uint32_t SETTINGS_AFTER_COMMAND_MS = 1000;
+
+  void set_interval(PollPhase phase, uint32_t interval_ms);
+  void set_settings_refresh(uint32_t interval_ms) { settings_refresh_ms_ = interval_ms; }
+  uint32_t interval(PollPhase phase) const { return intervals_[phase]; }
+  PollPhase phase() const { return phase_; }
+
+  // Bedienteil übernimmt: beim nächsten Wechsel in den autonomen Betrieb sofort abfragen
+  void restart(uint32_t now_ms);
+  void on_status(uint16_t status_code, uint32_t now_ms);
+  // Settings-Antwort der Heizung, egal wer gefragt hat
+  void on_settings(uint32_t now_ms);
+  // Eigener Frame zur Heizung: Abfragen verschieben den nächsten Termin,
+  // Kommandos ziehen Status- und Settings-Abfrage vor
+  void on_frame_sent(const uint8_t *frame, size_t length, uint32_t now_ms);
+
+  bool status_due(uint32_t now_ms) const { return static_cast<int32_t>(now_ms - next_status_ms_) >= 0; }
+  bool settings_due(uint32_t now_ms) const { return static_cast<int32_t>(now_ms - next_settings_ms_) >= 0; }
+
+ protected:
+  static bool earlier_(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+  uint32_t intervals_[POLL_PHASE_COUNT]{DEFAULT_STANDBY_MS, DEFAULT_STARTUP_MS, DEFAULT_RUNNING_MS,
+                                        DEFAULT_SHUTDOWN_MS};
+  uint32_t settings_refresh_ms_{DEFAULT_SETTINGS_REFRESH_MS};
+  PollPhase phase_{POLL_PHASE_RUNNING};
+  uint32_t last_status_request_ms_{0};
+  uint32_t next_status_ms_{0};
+  uint32_t next_settings_ms_{0};
+};
+
+}  // namespace autoterm
@@ -10,13 +10,21 @@
 #include "esphome/core/preferences.h"
 #include "esphome/core/helpers.h"
 #include "esphome/core/string_ref.h"
+#include "autoterm_protocol.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cmath>
+#include <cstring>
 #include <set>
 #include <string>
 #include <vector>
 
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
 namespace esphome {
 namespace autoterm_uart {
 
@@ -26,6 +34,77 @@ using namespace esphome::sensor;
 class AutotermUART;  // Vorwärtsdeklaration
 class AutotermClimate;  // Vorwärtsdeklaration
 
+// Frame-Tracing kostet nur etwas, wenn Debug-Logs überhaupt einkompiliert werden
+#if defined(ESPHOME_LOG_LEVEL) && ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+#define AUTOTERM_UART_TRACE
+#endif
+
+// Zustandszähler je Richtung, die als Diagnosesensor veröffentlicht werden können
+enum TelemetryCounter : uint8_t {
+  TELEMETRY_FRAMES = 0,
+  TELEMETRY_BYTES,
+  TELEMETRY_CRC_ERRORS,
+  TELEMETRY_PASSTHROUGH_BYTES,
+  TELEMETRY_OVERFLOW_BYTES,
+  TELEMETRY_RESYNCS,
+  TELEMETRY_FALSE_STARTS,
+  TELEMETRY_GAP_FLUSHES,
+  TELEMETRY_REWRITTEN,
+  TELEMETRY_INJECTED,
+  TELEMETRY_FRAMES_START,  // ab hier in der Reihenfolge von autoterm::TRACKED_COMMANDS
+  TELEMETRY_FRAMES_SETTINGS,
+  TELEMETRY_FRAMES_STANDBY,
+  TELEMETRY_FRAMES_STATUS,
+  TELEMETRY_FRAMES_PANEL_TEMPERATURE,
+  TELEMETRY_FRAMES_FAN_ONLY,
+  TELEMETRY_FRAMES_OTHER,
+  TELEMETRY_BUS_UTILISATION,
+  TELEMETRY_COUNT,
+};
+static_assert(TELEMETRY_FRAMES_OTHER - TELEMETRY_FRAMES_START == autoterm::COMMAND_SLOT_OTHER,
+              "Telemetrie-Zähler passen nicht zu autoterm::TRACKED_COMMANDS");
+
+// Laufzeitmessung der loop()-Abschnitte per Zyklenzähler (loop_profiler im YAML)
+enum LoopStage : uint8_t {
+  LOOP_STAGE_TOTAL = 0,
+  LOOP_STAGE_FORWARD_DISPLAY,
+  LOOP_STAGE_FORWARD_HEATER,
+  LOOP_STAGE_FRAME,
+  LOOP_STAGE_PARSE_STATUS,
+  LOOP_STAGE_PARSE_SETTINGS,
+  LOOP_STAGE_COMMANDS,
+  LOOP_STAGE_POLL,
+  LOOP_STAGE_RUNTIME,
+  LOOP_STAGE_THERMOSTAT,
+  LOOP_STAGE_TRACE,
+  LOOP_STAGE_COUNT,
+};
+
+// Schreibt direkt in den UART-Treiber (Ziel der TX-Queue)
+class UARTByteSink : public autoterm::ByteSink {
+ public:
+  explicit UARTByteSink(UARTComponent *uart) : uart_(uart) {}
+  void write(const uint8_t *data, size_t length) override { uart_->write_array(data, length); }
+
+ protected:
+  UARTComponent *uart_;
+};
+
+using BridgeTxQueue = autoterm::TxQueue<256>;
+
+// Statussensoren mit Deadband/Heartbeat-Filter (Index in publish_filters_)
+enum StatusSensor : uint8_t {
+  STATUS_SENSOR_INTERNAL_TEMP = 0,
+  STATUS_SENSOR_EXTERNAL_TEMP,
+  STATUS_SENSOR_HEATER_TEMP,
+  STATUS_SENSOR_VOLTAGE,
+  STATUS_SENSOR_STATUS,
+  STATUS_SENSOR_FAN_SPEED_SET,
+  STATUS_SENSOR_FAN_SPEED_ACTUAL,
+  STATUS_SENSOR_PUMP_FREQUENCY,
+  STATUS_SENSOR_COUNT,
+};
+
 // ===================
 // Custom Number Class
 // ===================
@@ -38,6 +117,7 @@ class AutotermFanLevelNumber : public number::Number {
   void control(float value) override;  // Implementierung folgt unten
 };
 
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
 class AutotermTempSourceSelect : public select::Select {
  public:
   void set_parent(AutotermUART *parent);
@@ -51,11 +131,12 @@ class AutotermTempSourceSelect : public select::Select {
   const char *option_from_source_(uint8_t source) const;
   uint8_t source_from_option_(const std::string &option) const;
 };
+#endif
 
 // ===================
 // Hauptklasse UART
 // ===================
-class AutotermUART : public Component {
+class AutotermUART : public Component, protected autoterm::BridgeChannelListener {
   friend class AutotermTempSourceSelect;
 
  public:
@@ -73,18 +154,49 @@ class AutotermUART : public Component {
   Sensor *fan_speed_actual_sensor_{nullptr};
   Sensor *pump_frequency_sensor_{nullptr};
   text_sensor::TextSensor *status_text_sensor_{nullptr};
+  autoterm::PublishFilter publish_filters_[STATUS_SENSOR_COUNT];
+  uint32_t publish_heartbeat_ms_{60000};
+  uint32_t publishes_sent_{0};
+  uint32_t publishes_suppressed_{0};
+  uint16_t status_text_code_{0};
+  bool status_text_published_{false};
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
   Sensor *panel_temp_override_sensor_{nullptr};
+#endif
   float panel_temp_override_value_c_{NAN};
 
+  // Diagnose
+  Sensor *response_time_p50_sensor_{nullptr};
+  Sensor *response_time_p95_sensor_{nullptr};
+  Sensor *request_timeouts_sensor_{nullptr};
+  Sensor *first_forward_sensor_{nullptr};
+  Sensor *display_failover_sensor_{nullptr};
+  // Zeit seit dem Reset bis zum ersten weitergeleiteten Frame (0 = noch keiner)
+  std::atomic<uint32_t> first_forward_millis_{0};
+  bool first_forward_published_{false};
+  bool bridge_first_{false};
+  uint32_t last_diagnostics_publish_millis_{0};
+  // [0] display→heater, [1] heater→display
+  Sensor *telemetry_sensors_[2][TELEMETRY_COUNT]{};
+  float bus_utilisation_[2]{0.0f, 0.0f};  // geglättete Auslastung der Zielleitung in %
+  uint32_t utilisation_bytes_[2]{0, 0};
+  uint32_t last_utilisation_millis_{0};
+
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
   AutotermTempSourceSelect *temp_source_select_{nullptr};
+#endif
   bool manual_temp_source_active_{false};
   uint8_t manual_temp_source_value_{0};
   float last_internal_temp_c_{NAN};
   float last_external_temp_c_{NAN};
 
   AutotermFanLevelNumber *fan_level_number_{nullptr};
+#ifdef AUTOTERM_UART_CLIMATE
   AutotermClimate *climate_{nullptr};
+#endif
 
+  bool heater_running_{false};
+#ifdef AUTOTERM_UART_RUNTIME
   Sensor *runtime_hours_sensor_{nullptr};
   Sensor *session_runtime_sensor_{nullptr};
   ESPPreferenceObject runtime_hours_pref_;
@@ -96,44 +208,118 @@ class AutotermUART : public Component {
   bool runtime_dirty_{false};
   bool runtime_tracking_initialized_{false};
   bool runtime_storage_initialized_{false};
-  bool heater_running_{false};
   uint32_t last_runtime_millis_{0};
   uint32_t last_runtime_save_millis_{0};
+#endif
 
-  struct Settings {
-    uint8_t use_work_time = 1;
-    uint8_t work_time = 0;
-    uint8_t temperature_source = 4;
-    uint8_t set_temperature = 16;
-    uint8_t wait_mode = 0;
-    uint8_t power_level = 8;
-  } settings_;
+  using Settings = autoterm::Settings;
+  Settings settings_;
   bool settings_valid_{false};
-
-  bool display_connected_state_{false};
-  uint32_t last_display_activity_{0};
-  uint32_t last_status_request_millis_{0};
-  uint32_t last_settings_request_millis_{0};
+  // settings_ stammt aus dem Flash und ist von der Heizung noch nicht bestätigt
+  bool settings_restored_{false};
+
+  // Zuletzt bekannter Zustand für einen schnellen Start; Layout unabhängig von den Feature-Defines
+  struct PersistedState {
+    uint8_t version;
+    bool settings_valid;
+    Settings settings;
+    uint8_t manual_temp_source;  // 0 = keine manuelle Wahl
+    uint8_t climate_mode;
+    uint8_t climate_preset;  // Index in AutotermClimate::PRESETS, 0xFF = keins
+    uint8_t climate_level;
+    float climate_target_c;
+    bool thermostat_active;
+    uint8_t thermostat_level;
+    uint8_t thermostat_sensor_source;
+    float thermostat_target_c;
+    float thermostat_hys_on_c;
+    float thermostat_hys_off_c;
+  };
+  static constexpr uint8_t PERSISTED_STATE_VERSION = 1;
+  // Änderungen sammeln, statt bei jedem Schritt in den Flash zu schreiben
+  static constexpr uint32_t STATE_SAVE_DELAY_MS = 5000;
+  ESPPreferenceObject state_pref_;
+  PersistedState saved_state_{};
+  bool state_storage_initialized_{false};
+  bool state_dirty_{false};
+  uint32_t state_dirty_since_millis_{0};
+
+  autoterm::DisplayPresence display_presence_;
+  // Von der Weiterleitung geschrieben (ggf. im Bridge-Task), im Hauptloop gelesen
+  std::atomic<uint32_t> last_bus_activity_{0};
+  // Umschreibregeln, im Hauptloop berechnet und beim Weiterleiten angewendet (-1 = aus)
+  std::atomic<int16_t> panel_override_byte_{-1};
+  std::atomic<int16_t> forced_source_byte_{-1};
   uint32_t last_panel_temp_send_millis_{0};
   float panel_temp_last_value_c_{NAN};
 
-  std::vector<uint8_t> display_to_heater_buffer_;
-  std::vector<uint8_t> heater_to_display_buffer_;
-
-  bool thermostat_active_{false};
-  bool thermostat_heating_request_{false};
-  bool thermostat_waiting_for_idle_{false};
-  float thermostat_target_c_{20.0f};
-  float thermostat_hys_on_c_{2.0f};
-  float thermostat_hys_off_c_{1.0f};
-  uint8_t thermostat_level_{4};
+  autoterm::BridgeChannel display_to_heater_{"display→heater", true};
+  autoterm::BridgeChannel heater_to_display_{"heater→display", false};
+  BridgeTxQueue display_tx_;  // Bytes Richtung Bedienteil
+  BridgeTxQueue heater_tx_;   // Bytes Richtung Heizung
+  // Größte Blocklänge pro read_array(); ein Frame passt in einen Block
+  static constexpr size_t RX_CHUNK = 64;
+
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+  // Vollständiger Frame aus dem Bridge-Task für die Auswertung im Hauptloop
+  struct BridgeFrame {
+    uint32_t time_ms;
+    uint8_t length;
+    bool from_display;
+    bool crc_valid;
+    uint8_t data[autoterm::BridgeFrameAssembler::MAX_ASSEMBLED_FRAME];
+  };
+  static constexpr uint32_t BRIDGE_TASK_STACK = 4096;
+  autoterm::SpscQueue<BridgeFrame, 8> bridge_frames_;                   // Task → Hauptloop
+  autoterm::SpscQueue<autoterm::ScheduledCommand, 4> bridge_injections_;  // Hauptloop → Task
+  autoterm::RelaxedCounter bridge_frame_drops_;
+  std::atomic<bool> bridge_line_busy_{false};
+  std::atomic<bool> bridge_task_active_{false};
+  TaskHandle_t bridge_task_handle_{nullptr};
+  bool bridge_task_enabled_{false};
+  uint8_t bridge_task_core_{1};
+  uint8_t bridge_task_priority_{12};
+#endif
+  autoterm::CommandScheduler command_scheduler_;
+  autoterm::RequestTracker request_tracker_;
+  autoterm::PollScheduler poll_scheduler_;
+  static constexpr uint32_t DIAGNOSTICS_PUBLISH_INTERVAL_MS = 60000;
+
+#ifdef AUTOTERM_UART_TRACE
+  // 32 Byte reichen für alle bekannten Frames (Status: 26 Byte)
+  using FrameTraceRing = autoterm::TraceRing<16, 32>;
+  FrameTraceRing frame_trace_;
+  static constexpr uint8_t TRACE_DRAIN_PER_LOOP = 2;
+#endif
+
+#ifdef AUTOTERM_UART_PROFILE
+  // Log-Buckets in µs bis 131 ms, so dass auch Aussetzer von 50-70 ms ein p99 haben
+  using StageHistogram = autoterm::LogHistogram<64>;
+  StageHistogram loop_profile_[LOOP_STAGE_COUNT];
+  Sensor *loop_stage_sensors_[LOOP_STAGE_COUNT]{};
+  uint32_t cycles_per_us_{1};
+  uint32_t profile_claimed_{0};  // Summe aller bisher verbuchten Abschnittszeiten (Zyklen)
+#endif
+
+#ifdef AUTOTERM_UART_CLIMATE
+  // Regelentscheidungen im Protokoll-Kern, hier nur Senden und Loggen
+  autoterm::ThermostatEngine thermostat_;
   uint8_t thermostat_sensor_source_{1};
-  uint8_t thermostat_last_sent_level_{255};
-  uint32_t thermostat_last_command_millis_{0};
-  uint32_t thermostat_last_evaluation_millis_{0};
+#endif
 
   void set_uart_display(UARTComponent *u) { uart_display_ = u; }
   void set_uart_heater(UARTComponent *u) { uart_heater_ = u; }
+  void set_cut_through(bool enabled) {
+    display_to_heater_.set_cut_through(enabled);
+    heater_to_display_.set_cut_through(enabled);
+  }
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+  void set_bridge_task(uint8_t core, uint8_t priority) {
+    bridge_task_enabled_ = true;
+    bridge_task_core_ = core;
+    bridge_task_priority_ = priority;
+  }
+#endif
 
   // Sensor-Setter
   void set_internal_temp_sensor(Sensor *s) { internal_temp_sensor_ = s; }
@@ -144,6 +330,22 @@ class AutotermUART : public Component {
   void set_fan_speed_set_sensor(Sensor *s) { fan_speed_set_sensor_ = s; }
   void set_fan_speed_actual_sensor(Sensor *s) { fan_speed_actual_sensor_ = s; }
   void set_pump_frequency_sensor(Sensor *s) { pump_frequency_sensor_ = s; }
+  void set_response_time_p50_sensor(Sensor *s) { response_time_p50_sensor_ = s; }
+  void set_response_time_p95_sensor(Sensor *s) { response_time_p95_sensor_ = s; }
+  void set_request_timeouts_sensor(Sensor *s) { request_timeouts_sensor_ = s; }
+  void set_first_forward_sensor(Sensor *s) { first_forward_sensor_ = s; }
+  void set_display_failover_sensor(Sensor *s) { display_failover_sensor_ = s; }
+  void set_display_missed_frames(uint8_t missed) { display_presence_.set_missed_frames(missed); }
+  void set_display_timeout(uint32_t timeout_ms) { display_presence_.set_max_timeout(timeout_ms); }
+  // Direkt nach den UARTs starten, vor WLAN, API und den übrigen Komponenten
+  void set_bridge_first(bool enabled) { bridge_first_ = enabled; }
+  float get_setup_priority() const override {
+    return bridge_first_ ? setup_priority::BUS - 1.0f : setup_priority::DATA;
+  }
+  void set_telemetry_sensor(bool from_display, TelemetryCounter counter, Sensor *s) {
+    if (counter < TELEMETRY_COUNT)
+      telemetry_sensors_[from_display ? 0 : 1][counter] = s;
+  }
 
   void set_panel_temp_sensor(Sensor *s) {
     panel_temp_sensor_ = s;
@@ -153,13 +355,36 @@ class AutotermUART : public Component {
   }
 
   void set_status_text_sensor(text_sensor::TextSensor *s) { status_text_sensor_ = s; }
+  void set_publish_deadband(StatusSensor sensor, float deadband) {
+    if (sensor < STATUS_SENSOR_COUNT)
+      publish_filters_[sensor].set_deadband(deadband);
+  }
+  void set_publish_heartbeat(uint32_t heartbeat_ms) { publish_heartbeat_ms_ = heartbeat_ms; }
+  void set_poll_interval(autoterm::PollPhase phase, uint32_t interval_ms) {
+    poll_scheduler_.set_interval(phase, interval_ms);
+  }
+  void set_settings_refresh_interval(uint32_t interval_ms) { poll_scheduler_.set_settings_refresh(interval_ms); }
+#ifdef AUTOTERM_UART_PROFILE
+  void set_loop_stage_sensor(LoopStage stage, Sensor *s) {
+    if (stage < LOOP_STAGE_COUNT)
+      loop_stage_sensors_[stage] = s;
+  }
+#endif
+  // Loggt min/avg/max/p99 aller loop()-Abschnitte (z. B. aus einem Button-Lambda)
+  void dump_loop_profile();
 
+#ifdef AUTOTERM_UART_RUNTIME
   void set_runtime_hours_sensor(Sensor *s);
   void set_session_runtime_sensor(Sensor *s);
+#endif
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
   void set_panel_temp_override_sensor(Sensor *s);
+#endif
 
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
   void set_temp_source_select(AutotermTempSourceSelect *select);
   void set_temp_source_from_select(uint8_t source);
+#endif
   void apply_temp_source_from_settings(uint8_t source);
 
   uint8_t get_manual_temp_source() const { return manual_temp_source_active_ ? manual_temp_source_value_ : 0; }
@@ -172,7 +397,9 @@ class AutotermUART : public Component {
     if (n) n->setup_parent(this);
   }
 
+#ifdef AUTOTERM_UART_CLIMATE
   void set_climate(AutotermClimate *climate);
+#endif
 
   // Kommandos für Betriebsarten
   void send_standby();
@@ -181,39 +408,57 @@ class AutotermUART : public Component {
   void send_temperature_to_fan_mode(bool start, uint8_t temp_sensor, uint8_t set_temp);
   void send_fan_only(uint8_t level);
 
+#ifdef AUTOTERM_UART_CLIMATE
   void configure_thermostat_mode(float target_c, uint8_t level, uint8_t sensor_source,
                                  float hys_on_c, float hys_off_c);
   void disable_thermostat_mode();
+#endif
+  // Merkt den aktuellen Zustand zum (verzögerten) Speichern im Flash vor
+  void request_state_save();
 
   void loop() override {
-    forward_and_sniff(uart_display_, uart_heater_, "display→heater", true);
-    forward_and_sniff(uart_heater_, uart_display_, "heater→display");
+    ProfileMark loop_start = profile_start_();
+    ProfileMark stage_start = loop_start;
+    update_rewrite_policy_();
+    if (bridge_task_running_()) {
+      drain_bridge_frames_();
+      stage_start = profile_end_(LOOP_STAGE_FRAME, stage_start);
+    } else {
+      forward_and_sniff(uart_display_, uart_heater_, heater_tx_, display_to_heater_);
+      stage_start = profile_end_(LOOP_STAGE_FORWARD_DISPLAY, stage_start);
+      forward_and_sniff(uart_heater_, uart_display_, display_tx_, heater_to_display_);
+      stage_start = profile_end_(LOOP_STAGE_FORWARD_HEATER, stage_start);
+    }
+    service_tx_();
+    service_commands_();
+    retry_requests_();
+    stage_start = profile_end_(LOOP_STAGE_COMMANDS, stage_start);
 
     uint32_t now = millis();
-    bool connected = uart_display_ != nullptr && (now - last_display_activity_) < 5000;
-
-    if (connected != display_connected_state_) {
-      display_connected_state_ = connected;
-      if (connected) {
-        ESP_LOGI("autoterm_uart", "Display connection detected");
-        last_status_request_millis_ = now;
-        last_settings_request_millis_ = now;
-        last_panel_temp_send_millis_ = now;
-      } else {
-        ESP_LOGW("autoterm_uart", "Display connection lost, switching to autonomous mode");
+    switch (display_presence_.poll(now)) {
+      case autoterm::DisplayEvent::LOST: {
+        uint32_t failover = now - display_presence_.last_frame_ms();
+        ESP_LOGW("autoterm_uart", "Display silent for %ums (cadence %ums), switching to autonomous mode",
+                 static_cast<unsigned>(failover), static_cast<unsigned>(display_presence_.cadence_ms()));
         last_panel_temp_send_millis_ = 0;
+        if (display_failover_sensor_) display_failover_sensor_->publish_state(failover);
+        break;
       }
+      case autoterm::DisplayEvent::ABSENT:
+        ESP_LOGI("autoterm_uart", "No display frames since start, using autonomous mode");
+        last_panel_temp_send_millis_ = 0;
+        break;
+      default:
+        break;
     }
 
-    if (!connected) {
-      if (now - last_status_request_millis_ >= 2000) {
+    if (!display_presence_.connected()) {
+      // Takt je Betriebsphase; eine Anfrage wartet immer erst auf ihre Antwort
+      if (poll_scheduler_.status_due(now) && !poll_request_pending_(autoterm::STATUS_REQUEST_FRAME))
         send_status_request();
-        last_status_request_millis_ = now;
-      }
-      if (now - last_settings_request_millis_ >= 10000) {
+      if (poll_scheduler_.settings_due(now) && !poll_request_pending_(autoterm::SETTINGS_REQUEST_FRAME))
         request_settings();
-        last_settings_request_millis_ = now;
-      }
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
       if (should_override_panel_temperature_() && std::isfinite(panel_temp_override_value_c_)) {
         if (last_panel_temp_send_millis_ == 0 ||
             (now - last_panel_temp_send_millis_) >= 1000) {
@@ -221,17 +466,54 @@ class AutotermUART : public Component {
           last_panel_temp_send_millis_ = now;
         }
       }
+#endif
     }
+    stage_start = profile_end_(LOOP_STAGE_POLL, stage_start);
 
+#ifdef AUTOTERM_UART_RUNTIME
     uint32_t runtime_now = millis();
     advance_runtime_time_(runtime_now);
     maybe_save_runtime_hours_(runtime_now);
+    stage_start = profile_end_(LOOP_STAGE_RUNTIME, stage_start);
+#endif
 
-    if (thermostat_active_)
+#ifdef AUTOTERM_UART_CLIMATE
+    if (thermostat_.active())
       evaluate_thermostat_control_();
+    stage_start = profile_end_(LOOP_STAGE_THERMOSTAT, stage_start);
+#endif
+
+    update_bus_utilisation_(now);
+    publish_diagnostics_(now);
+    maybe_save_state_(now);
+
+    service_tx_();
+    stage_start = profile_start_();
+    drain_trace_();
+    profile_end_(LOOP_STAGE_TRACE, stage_start);
+    profile_total_(loop_start);
   }
 
   void setup() override {
+#ifdef AUTOTERM_UART_PROFILE
+    cycles_per_us_ = std::max<uint32_t>(1, arch_get_cpu_freq_hz() / 1000000);
+#endif
+    if (uart_display_ != nullptr) {
+      display_tx_.set_baud_rate(uart_display_->get_baud_rate());
+      display_to_heater_.set_baud_rate(uart_display_->get_baud_rate());
+      display_presence_.start(millis());
+    }
+    if (uart_heater_ != nullptr) {
+      heater_tx_.set_baud_rate(uart_heater_->get_baud_rate());
+      heater_to_display_.set_baud_rate(uart_heater_->get_baud_rate());
+    }
+    update_rewrite_policy_();
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+    if (bridge_task_enabled_)
+      start_bridge_task_();
+#endif
+
+#ifdef AUTOTERM_UART_RUNTIME
     if (global_preferences != nullptr) {
       runtime_hours_pref_ =
           global_preferences->make_preference<float>(fnv1_hash("autoterm_uart_runtime_hours"));
@@ -256,76 +538,452 @@ class AutotermUART : public Component {
     last_runtime_millis_ = now;
     last_runtime_save_millis_ = now;
     runtime_tracking_initialized_ = true;
+#endif
 
+    restore_state_();
     request_settings();
   }
 
+  void dump_config() override {
+    ESP_LOGCONFIG("autoterm_uart", "Autoterm UART Bridge:");
+    ESP_LOGCONFIG("autoterm_uart", "  Forwarding: %s",
+                  display_to_heater_.cut_through() ? "cut-through" : "store-and-forward");
+    ESP_LOGCONFIG("autoterm_uart", "  Bridge first: %s, first frame forwarded after %ums", bridge_first_ ? "yes" : "no",
+                  static_cast<unsigned>(first_forward_millis_.load(std::memory_order_relaxed)));
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+    if (bridge_task_running_()) {
+      ESP_LOGCONFIG("autoterm_uart", "  Bridge task: core=%u priority=%u frame_drops=%u",
+                    static_cast<unsigned>(bridge_task_core_), static_cast<unsigned>(bridge_task_priority_),
+                    static_cast<unsigned>(bridge_frame_drops_.get()));
+    }
+#endif
+    log_channel_stats_(display_to_heater_);
+    log_channel_stats_(heater_to_display_);
+    log_tx_stats_("→display", display_tx_);
+    log_tx_stats_("→heater", heater_tx_);
+    ESP_LOGCONFIG("autoterm_uart", "  Bus utilisation: →heater=%.1f%% →display=%.1f%%", bus_utilisation_[0],
+                  bus_utilisation_[1]);
+    const autoterm::CommandSchedulerStats &commands = command_scheduler_.stats();
+    ESP_LOGCONFIG("autoterm_uart", "  Commands: submitted=%u coalesced=%u redundant=%u injected=%u dropped=%u",
+                  static_cast<unsigned>(commands.submitted), static_cast<unsigned>(commands.coalesced),
+                  static_cast<unsigned>(commands.redundant), static_cast<unsigned>(commands.injected),
+                  static_cast<unsigned>(commands.dropped));
+    ESP_LOGCONFIG("autoterm_uart", "  Status publishes: sent=%u suppressed=%u (heartbeat %us)",
+                  static_cast<unsigned>(publishes_sent_), static_cast<unsigned>(publishes_suppressed_),
+                  static_cast<unsigned>(publish_heartbeat_ms_ / 1000));
+    ESP_LOGCONFIG("autoterm_uart", "  Display: %s, cadence %ums, timeout %ums",
+                  display_presence_.connected() ? "connected" : "absent",
+                  static_cast<unsigned>(display_presence_.cadence_ms()),
+                  static_cast<unsigned>(display_presence_.timeout_ms()));
+    const autoterm::RequestTrackerStats &requests = request_tracker_.stats();
+    const autoterm::RequestTracker::LatencyHistogram &rtt = request_tracker_.latency();
+    ESP_LOGCONFIG("autoterm_uart", "  Requests: answered=%u timeouts=%u retries=%u unmatched=%u",
+                  static_cast<unsigned>(requests.matched), static_cast<unsigned>(requests.timeouts),
+                  static_cast<unsigned>(requests.retries), static_cast<unsigned>(requests.unmatched));
+    ESP_LOGCONFIG("autoterm_uart", "  Response time: p50=%ums p95=%ums p99=%ums max=%ums (%u replies)",
+                  static_cast<unsigned>(rtt.percentile(50)), static_cast<unsigned>(rtt.percentile(95)),
+                  static_cast<unsigned>(rtt.percentile(99)), static_cast<unsigned>(rtt.max()),
+                  static_cast<unsigned>(rtt.count()));
+#ifdef AUTOTERM_UART_TRACE
+    ESP_LOGCONFIG("autoterm_uart", "  Frame trace: dropped=%u", static_cast<unsigned>(frame_trace_.dropped()));
+#endif
+#ifdef AUTOTERM_UART_CRC_BENCHMARK
+    benchmark_crc_();
+#endif
+#ifdef AUTOTERM_UART_PROFILE
+    dump_loop_profile();
+#endif
+  }
+
  protected:
-  void forward_and_sniff(UARTComponent *src, UARTComponent *dst, const char *tag,
-                         bool from_display = false) {
+  void forward_and_sniff(UARTComponent *src, UARTComponent *dst, BridgeTxQueue &dst_queue,
+                         autoterm::BridgeChannel &channel) {
     if (!src || !dst) return;
-    auto &buffer = from_display ? display_to_heater_buffer_ : heater_to_display_buffer_;
 
-    while (src->available()) {
-      uint8_t b;
-      if (!src->read_byte(&b)) break;
+    // Blockweise aus dem RX-Puffer des Treibers lesen statt Byte für Byte
+    uint8_t chunk[RX_CHUNK];
+    int available;
+    while ((available = src->available()) > 0) {
+      size_t length = std::min<size_t>(static_cast<size_t>(available), sizeof(chunk));
+      if (!src->read_array(chunk, length)) break;
 
-      buffer.push_back(b);
-      if (from_display)
-        last_display_activity_ = millis();
+      last_bus_activity_.store(millis(), std::memory_order_relaxed);
 
-      // Schraube lose Bytes vor dem Header direkt durch
-      while (!buffer.empty() && buffer[0] != 0xAA) {
-        dst->write_byte(buffer[0]);
-        buffer.erase(buffer.begin());
-      }
+      channel.push(chunk, length, micros(), dst_queue, *this);
+    }
+    // Erst nach dem Leeren prüfen, ob ein angefangener Frame abgebrochen ist
+    channel.poll_gap(micros(), dst_queue);
+  }
+
+  // Gibt höchstens ein wartendes Kommando frei, wenn der Bus zur Heizung frei ist
+  void service_commands_() {
+    if (uart_heater_ == nullptr || command_scheduler_.pending() == 0)
+      return;
+    uint32_t now = millis();
+    command_scheduler_.note_activity(last_bus_activity_.load(std::memory_order_relaxed));
+    bool line_busy;
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+    if (bridge_task_running_())
+      line_busy = bridge_line_busy_.load(std::memory_order_acquire) || !bridge_injections_.empty();
+    else
+#endif
+      line_busy = bridge_line_busy_now_();
+    if (!command_scheduler_.ready(now, line_busy))
+      return;
+
+    autoterm::ScheduledCommand command;
+    if (!command_scheduler_.pop(now, command))
+      return;
+    if (!inject_frame_(command)) {
+      ESP_LOGW("autoterm_uart", "TX queue to heater full, dropping command 0x%02X", command.frame[4]);
+      return;
+    }
+    // Antwortzeit ab dem letzten gesendeten Byte
+    uint32_t wire_ms = (command.length * heater_tx_.byte_time_us() + 999) / 1000;
+    request_tracker_.on_request(command.frame, command.length, now + wire_ms, true, command.label);
+    poll_scheduler_.on_frame_sent(command.frame, command.length, now + wire_ms);
+    trace_(autoterm::TraceKind::COMMAND, command.label != nullptr ? command.label : "frame", command.frame,
+           command.length);
+  }
+
+  // Übergabe an das Bedienteil: eigene Abfragen nicht doppelt zum Takt des Bedienteils senden
+  void on_display_connected_(uint32_t now) {
+    size_t dropped = command_scheduler_.drop_requests();
+    ESP_LOGI("autoterm_uart", "Display connection detected, %u queued requests dropped",
+             static_cast<unsigned>(dropped));
+    // Eigene Anfragen weder als Timeout werten noch wiederholen
+    request_tracker_.cancel_own();
+    poll_scheduler_.restart(now);
+    last_panel_temp_send_millis_ = now;
+  }
+
+  // Abfrage schon eingeplant oder unterwegs (Wiederholungen übernimmt der RequestTracker)
+  template<size_t N> bool poll_request_pending_(const std::array<uint8_t, N> &frame) const {
+    return request_tracker_.in_flight(frame[4]) || command_scheduler_.has_pending(frame.data(), frame.size());
+  }
+
+  // Angefangener Frame in einer Richtung oder noch nicht gesendete Bytes zur Heizung
+  bool bridge_line_busy_now_() const {
+    return !display_to_heater_.idle() || !heater_to_display_.idle() || !heater_tx_.tx_complete(micros());
+  }
 
-      while (true) {
-        if (buffer.empty())
-          break;
-        if (buffer[0] != 0xAA)
-          break;
-        if (buffer.size() < 3)
-          break;
-
-        uint8_t len = buffer[2];
-        size_t total = 5 + static_cast<size_t>(len) + 2;
-        if (buffer.size() < total)
-          break;
-
-        std::vector<uint8_t> frame(buffer.begin(), buffer.begin() + total);
-        process_frame_(std::move(frame), dst, tag, from_display);
-        buffer.erase(buffer.begin(), buffer.begin() + total);
+  // Legt ein freigegebenes Kommando auf die Leitung (oder übergibt es dem Bridge-Task)
+  bool inject_frame_(const autoterm::ScheduledCommand &command) {
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+    if (bridge_task_running_()) {
+      if (!bridge_injections_.push(command))
+        return false;
+      xTaskNotifyGive(bridge_task_handle_);
+      return true;
+    }
+#endif
+    if (!heater_tx_.enqueue(command.frame, command.length))
+      return false;
+    display_to_heater_.count_injected();
+    service_tx_();
+    return true;
+  }
+
+  // Überträgt den aktuellen Override-Zustand in die Regeln für die Weiterleitung
+  void update_rewrite_policy_() {
+    panel_override_byte_.store(should_override_panel_temperature_() ? compute_override_temperature_byte_() : -1,
+                               std::memory_order_relaxed);
+    forced_source_byte_.store(should_force_temp_source_() ? map_source_to_heater_(manual_temp_source_value_) : -1,
+                              std::memory_order_relaxed);
+  }
+
+  bool bridge_task_running_() const {
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+    return bridge_task_active_.load(std::memory_order_acquire);
+#else
+    return false;
+#endif
+  }
+
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+  void start_bridge_task_() {
+    BaseType_t core = std::min<BaseType_t>(bridge_task_core_, portNUM_PROCESSORS - 1);
+    // Vor dem Start setzen: der Task kann auf dem anderen Kern sofort loslaufen
+    bridge_task_active_.store(true, std::memory_order_release);
+    if (xTaskCreatePinnedToCore(bridge_task_, "autoterm_bridge", BRIDGE_TASK_STACK, this, bridge_task_priority_,
+                                &bridge_task_handle_, core) != pdPASS) {
+      bridge_task_active_.store(false, std::memory_order_release);
+      bridge_task_handle_ = nullptr;
+      ESP_LOGE("autoterm_uart", "Bridge task could not be started, forwarding in loop()");
+    }
+  }
+
+  static void bridge_task_(void *arg) {
+    auto *self = static_cast<AutotermUART *>(arg);
+    const TickType_t delay = std::max<TickType_t>(1, pdMS_TO_TICKS(1));
+    for (;;) {
+      self->bridge_iteration_();
+      // Schläft bis zum nächsten Tick (ein Byte bei 9600 Baud) oder bis ein eigenes Kommando wartet
+      ulTaskNotifyTake(pdTRUE, delay);
+    }
+  }
+
+  // Läuft ausschließlich im Bridge-Task: Weiterleitung, eigene Frames, UART-Schreiben
+  void bridge_iteration_() {
+    forward_and_sniff(uart_display_, uart_heater_, heater_tx_, display_to_heater_);
+    forward_and_sniff(uart_heater_, uart_display_, display_tx_, heater_to_display_);
+
+    // Eigene Frames nur zwischen zwei Frames des Bedienteils einfügen. Ist die
+    // TX-Queue voll, bleibt das Kommando stehen, bis sie sich geleert hat.
+    const autoterm::ScheduledCommand *command = bridge_injections_.front();
+    if (command != nullptr && display_to_heater_.idle() && heater_tx_.enqueue(command->frame, command->length)) {
+      display_to_heater_.count_injected();
+      bridge_injections_.pop();
+    }
+
+    write_tx_queues_();
+    bridge_line_busy_.store(bridge_line_busy_now_(), std::memory_order_release);
+  }
+
+  // Übergibt die vom Bridge-Task gesammelten Frames an die Auswertung
+  void drain_bridge_frames_() {
+    const BridgeFrame *frame;
+    while ((frame = bridge_frames_.front()) != nullptr) {
+      const autoterm::BridgeChannel &channel = frame->from_display ? display_to_heater_ : heater_to_display_;
+      handle_frame_(channel, frame->data, frame->length, frame->crc_valid, frame->time_ms);
+      bridge_frames_.pop();
+    }
+  }
+#else
+  void drain_bridge_frames_() {}
+#endif
+
+  // Eigene Anfragen ohne Antwort erneut einplanen, sofern nichts Neueres wartet
+  void retry_requests_() {
+    autoterm::ScheduledCommand retry;
+    while (request_tracker_.poll(millis(), retry)) {
+      // Verworfene Wiederholung gibt ihren Slot frei, die neuere Anfrage (eigene oder
+      // des Bedienteils) belegt ihn neu
+      if (command_scheduler_.has_pending(retry.frame, retry.length) || display_presence_.connected()) {
+        request_tracker_.cancel(retry.frame[4]);
+        continue;
       }
+      ESP_LOGD("autoterm_uart", "No reply to request 0x%02X, retrying", retry.frame[4]);
+      send_frame_(retry.frame, retry.length, retry.label);
+    }
+  }
+
+  // Sekündlich gemessene Leitungsauslastung, exponentiell geglättet (~5 s)
+  void update_bus_utilisation_(uint32_t now) {
+    uint32_t elapsed = now - last_utilisation_millis_;
+    if (elapsed < 1000)
+      return;
+    last_utilisation_millis_ = now;
+    const BridgeTxQueue *queues[2] = {&heater_tx_, &display_tx_};
+    for (int i = 0; i < 2; i++) {
+      uint32_t written = queues[i]->stats().bytes_written.get();
+      uint32_t delta = written - utilisation_bytes_[i];
+      utilisation_bytes_[i] = written;
+      float load = 100.0f * static_cast<float>(delta) * queues[i]->byte_time_us() / (elapsed * 1000.0f);
+      bus_utilisation_[i] += 0.2f * (std::min(load, 100.0f) - bus_utilisation_[i]);
+    }
+  }
+
+  void publish_telemetry_(const autoterm::BridgeChannel &channel, int direction) {
+    Sensor *const *sensors = telemetry_sensors_[direction];
+    const autoterm::FrameAssemblerStats &stats = channel.stats();
+    const autoterm::ChannelTelemetry &telemetry = channel.telemetry();
+    const uint32_t counters[TELEMETRY_FRAMES_START] = {
+        stats.frames.get(),         stats.bytes.get(),        telemetry.crc_errors.get(), stats.passthrough_bytes.get(),
+        stats.overflow_bytes.get(), stats.resyncs.get(),      stats.false_starts.get(),   stats.gap_flushes.get(),
+        telemetry.rewritten.get(),  telemetry.injected.get()};
+    for (uint8_t i = 0; i < TELEMETRY_FRAMES_START; i++) {
+      if (sensors[i] != nullptr)
+        sensors[i]->publish_state(counters[i]);
+    }
+    for (uint8_t i = 0; i <= autoterm::COMMAND_SLOT_OTHER; i++) {
+      if (sensors[TELEMETRY_FRAMES_START + i] != nullptr)
+        sensors[TELEMETRY_FRAMES_START + i]->publish_state(telemetry.commands[i].get());
+    }
+    if (sensors[TELEMETRY_BUS_UTILISATION] != nullptr)
+      sensors[TELEMETRY_BUS_UTILISATION]->publish_state(bus_utilisation_[direction]);
+  }
 
-      if (buffer.size() > 64) {
-        for (uint8_t byte : buffer)
-          dst->write_byte(byte);
-        buffer.clear();
+  void publish_diagnostics_(uint32_t now) {
+    if (!first_forward_published_) {
+      uint32_t first = first_forward_millis_.load(std::memory_order_relaxed);
+      if (first != 0) {
+        ESP_LOGI("autoterm_uart", "First frame forwarded %ums after reset", static_cast<unsigned>(first));
+        if (first_forward_sensor_) first_forward_sensor_->publish_state(first);
+        first_forward_published_ = true;
       }
     }
+    if (now - last_diagnostics_publish_millis_ < DIAGNOSTICS_PUBLISH_INTERVAL_MS)
+      return;
+    last_diagnostics_publish_millis_ = now;
+
+    const autoterm::RequestTracker::LatencyHistogram &rtt = request_tracker_.latency();
+    if (rtt.count() > 0) {
+      if (response_time_p50_sensor_) response_time_p50_sensor_->publish_state(rtt.percentile(50));
+      if (response_time_p95_sensor_) response_time_p95_sensor_->publish_state(rtt.percentile(95));
+      request_tracker_.reset_latency();
+    }
+    if (request_timeouts_sensor_) request_timeouts_sensor_->publish_state(request_tracker_.stats().timeouts);
+    publish_telemetry_(display_to_heater_, 0);
+    publish_telemetry_(heater_to_display_, 1);
+
+#ifdef AUTOTERM_UART_PROFILE
+    bool published = false;
+    for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+      if (loop_stage_sensors_[stage] != nullptr && loop_profile_[stage].count() > 0) {
+        loop_stage_sensors_[stage]->publish_state(loop_profile_[stage].percentile(99));
+        published = true;
+      }
+    }
+    // Mit Sensoren zeigt jedes Intervall ein eigenes Fenster, sonst Werte seit dem Start
+    if (published) {
+      for (auto &histogram : loop_profile_)
+        histogram.reset();
+    }
+#endif
   }
 
-  // CRC16 (Modbus)
-  bool validate_crc(const std::vector<uint8_t> &data) {
-    if (data.size() < 3) return false;
-    uint16_t expected = crc16_modbus_(data.data(), data.size() - 2);
-    uint16_t recv_crc = (data[data.size() - 2] << 8) | data[data.size() - 1];
-    return expected == recv_crc;
+  // Schiebt wartende Bytes beider Richtungen in die UART-FIFOs, ohne zu blockieren.
+  // Mit Bridge-Task gehören die TX-Queues allein dem Task.
+  void service_tx_() {
+    if (!bridge_task_running_())
+      write_tx_queues_();
   }
 
-  void log_frame(const char *tag, const std::vector<uint8_t> &data) {
-    std::string hex;
-    char temp[6];
-    for (auto v : data) {
-      sprintf(temp, "%02X ", v);
-      hex += temp;
+  void write_tx_queues_() {
+    uint32_t now = micros();
+    if (uart_display_ != nullptr) {
+      UARTByteSink driver(uart_display_);
+      display_tx_.service(now, driver);
+    }
+    if (uart_heater_ != nullptr) {
+      UARTByteSink driver(uart_heater_);
+      heater_tx_.service(now, driver);
     }
-    ESP_LOGD("autoterm_uart", "[%s] Frame (%u bytes): %s", tag, (unsigned)data.size(), hex.c_str());
   }
 
-  void parse_status(const std::vector<uint8_t> &data);
-  void parse_settings(const std::vector<uint8_t> &data, bool from_display);
+  void log_tx_stats_(const char *tag, const BridgeTxQueue &queue) const {
+    const autoterm::TxQueueStats &stats = queue.stats();
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] tx queue: depth=%u high_water=%u written=%u dropped=%u", tag,
+                  static_cast<unsigned>(stats.depth.get()), static_cast<unsigned>(stats.high_water.get()),
+                  static_cast<unsigned>(stats.bytes_written.get()), static_cast<unsigned>(stats.dropped_bytes.get()));
+  }
+
+  // BridgeChannelListener
+  bool may_rewrite_frame(const autoterm::BridgeChannel &channel, uint8_t device, uint8_t command) override;
+  bool rewrite_frame(const autoterm::BridgeChannel &channel, uint8_t *frame, size_t length) override;
+  void on_frame(const autoterm::BridgeChannel &channel, const uint8_t *frame, size_t length,
+                bool crc_valid) override;
+  void handle_frame_(const autoterm::BridgeChannel &channel, const uint8_t *frame, size_t length, bool crc_valid,
+                     uint32_t now);
+
+  void log_channel_stats_(const autoterm::BridgeChannel &channel) const {
+    const autoterm::FrameAssemblerStats &stats = channel.stats();
+    const autoterm::ChannelTelemetry &telemetry = channel.telemetry();
+    const autoterm::ForwardLatencyStats &latency = channel.latency();
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] frames=%u bytes=%u passthrough=%u overflow=%u resyncs=%u",
+                  channel.tag(), static_cast<unsigned>(stats.frames.get()), static_cast<unsigned>(stats.bytes.get()),
+                  static_cast<unsigned>(stats.passthrough_bytes.get()),
+                  static_cast<unsigned>(stats.overflow_bytes.get()), static_cast<unsigned>(stats.resyncs.get()));
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] false_starts=%u gap_flushes=%u", channel.tag(),
+                  static_cast<unsigned>(stats.false_starts.get()), static_cast<unsigned>(stats.gap_flushes.get()));
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] crc_errors=%u rewritten=%u injected=%u", channel.tag(),
+                  static_cast<unsigned>(telemetry.crc_errors.get()), static_cast<unsigned>(telemetry.rewritten.get()),
+                  static_cast<unsigned>(telemetry.injected.get()));
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] by code: 01=%u 02=%u 03=%u 0F=%u 11=%u 23=%u other=%u", channel.tag(),
+                  static_cast<unsigned>(telemetry.commands[0].get()), static_cast<unsigned>(telemetry.commands[1].get()),
+                  static_cast<unsigned>(telemetry.commands[2].get()), static_cast<unsigned>(telemetry.commands[3].get()),
+                  static_cast<unsigned>(telemetry.commands[4].get()), static_cast<unsigned>(telemetry.commands[5].get()),
+                  static_cast<unsigned>(telemetry.commands[autoterm::COMMAND_SLOT_OTHER].get()));
+    ESP_LOGCONFIG("autoterm_uart", "  [%s] forward latency: avg=%uus max=%uus last=%uus (%u frames)",
+                  channel.tag(), static_cast<unsigned>(latency.average_us()),
+                  static_cast<unsigned>(latency.max_us()), static_cast<unsigned>(latency.last_us()),
+                  static_cast<unsigned>(latency.count()));
+  }
+
+  // Zyklenstand und bis dahin verbuchte Abschnittszeit
+  struct ProfileMark {
+    uint32_t cycles{0};
+    uint32_t claimed{0};
+  };
+#ifdef AUTOTERM_UART_PROFILE
+  ProfileMark profile_start_() const { return {arch_get_cpu_cycle_count(), profile_claimed_}; }
+  // Verbucht die Zeit seit start ohne die darin verschachtelten Abschnitte (z. B.
+  // Frame-Auswertung während der Weiterleitung), damit sich die Abschnitte nicht
+  // doppelt zählen. Liefert den Startwert für den nächsten Abschnitt.
+  ProfileMark profile_end_(LoopStage stage, ProfileMark start) {
+    uint32_t end = arch_get_cpu_cycle_count();
+    uint32_t exclusive = (end - start.cycles) - (profile_claimed_ - start.claimed);
+    profile_claimed_ += exclusive;
+    loop_profile_[stage].add(exclusive / cycles_per_us_);
+    return {end, profile_claimed_};
+  }
+  // Gesamtlaufzeit von loop() einschließlich aller Abschnitte
+  void profile_total_(ProfileMark start) {
+    loop_profile_[LOOP_STAGE_TOTAL].add((arch_get_cpu_cycle_count() - start.cycles) / cycles_per_us_);
+  }
+#else
+  ProfileMark profile_start_() const { return {}; }
+  ProfileMark profile_end_(LoopStage, ProfileMark) { return {}; }
+  void profile_total_(ProfileMark) {}
+#endif
+
+#ifdef AUTOTERM_UART_TRACE
+  void trace_(autoterm::TraceKind kind, const char *label, const uint8_t *data, size_t length) {
+    frame_trace_.record(millis(), kind, label, data, length);
+  }
+#else
+  void trace_(autoterm::TraceKind, const char *, const uint8_t *, size_t) {}
+#endif
+
+  // Formatiert gepufferte Trace-Einträge erst nach der Weiterleitung, wenige pro loop()
+  void drain_trace_() {
+#ifdef AUTOTERM_UART_TRACE
+    for (uint8_t n = 0; n < TRACE_DRAIN_PER_LOOP; n++) {
+      const FrameTraceRing::Entry *entry = frame_trace_.front();
+      if (entry == nullptr)
+        break;
+      log_trace_entry_(*entry, millis() - entry->time_ms);
+      frame_trace_.pop_front();
+    }
+#endif
+  }
+
+#ifdef AUTOTERM_UART_TRACE
+  void log_trace_entry_(const FrameTraceRing::Entry &entry, uint32_t age_ms) const {
+    char hex[sizeof(entry.data) * 3 + 1];
+    if (entry.kind == autoterm::TraceKind::FRAME) {
+      autoterm::format_hex(entry.data, entry.length, hex, sizeof(hex));
+      ESP_LOGD("autoterm_uart", "[%s] Frame (%u bytes, %ums ago): %s%s", entry.label,
+               static_cast<unsigned>(entry.original_length), static_cast<unsigned>(age_ms), hex,
+               entry.length < entry.original_length ? " …" : "");
+      return;
+    }
+
+    size_t payload_length = entry.length - autoterm::FRAME_OVERHEAD;
+    autoterm::format_hex(entry.data + autoterm::FRAME_HEADER_LENGTH, payload_length, hex, sizeof(hex));
+    uint16_t crc = static_cast<uint16_t>((entry.data[entry.length - 2] << 8) | entry.data[entry.length - 1]);
+    ESP_LOGD("autoterm_uart", "Sent %s (cmd=0x%02X len=%u payload=[%s] crc=%04X, %ums ago)", entry.label,
+             entry.data[4], static_cast<unsigned>(payload_length), hex, crc, static_cast<unsigned>(age_ms));
+  }
+#endif
+
+  // Auswertung CRC-gültiger Frames, einmal dekodiert und nach Funktionscode verteilt
+  struct FrameRoute {
+    uint8_t command;
+    bool (*matches)(const autoterm::FrameView &frame);
+    void (AutotermUART::*handle)(const autoterm::FrameView &frame, bool from_display);
+    LoopStage stage;  // LOOP_STAGE_COUNT: nicht einzeln profiliert
+  };
+  static const FrameRoute FRAME_ROUTES[3];
+  void dispatch_frame_(const autoterm::FrameView &frame, bool from_display);
+  void on_status_frame_(const autoterm::FrameView &frame, bool from_display);
+  void on_settings_frame_(const autoterm::FrameView &frame, bool from_display);
+  void on_panel_temp_frame_(const autoterm::FrameView &frame, bool from_display);
+
+  void parse_status(const autoterm::StatusFrame &frame);
+  void publish_filtered_(Sensor *sensor, StatusSensor index, float value, uint32_t now);
+  void parse_settings(const autoterm::SettingsFrame &frame);
 
  public:
   void send_fan_mode(bool on, int level);
@@ -333,37 +991,44 @@ class AutotermUART : public Component {
  protected:
   void request_settings();
   void send_status_request();
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
   void send_panel_temperature_override_frame_();
-  bool is_panel_temperature_frame_(const std::vector<uint8_t> &frame) const;
-  void handle_panel_temperature_frame_(const std::vector<uint8_t> &frame);
-  void process_frame_(std::vector<uint8_t> frame, UARTComponent *dst, const char *tag, bool from_display);
+#endif
+  void handle_panel_temperature_frame_(const autoterm::PanelTempFrame &frame);
   bool should_override_panel_temperature_() const;
-  void apply_temp_source_override_(std::vector<uint8_t> &frame);
+  bool apply_temp_source_override_(const autoterm::FrameView &view, uint8_t *frame);
   uint8_t compute_override_temperature_byte_() const;
-  void update_crc_(std::vector<uint8_t> &frame);
-  bool send_command_(uint8_t command, const std::vector<uint8_t> &payload, const char *log_label);
-  uint16_t append_crc_(std::vector<uint8_t> &frame);
-  static uint16_t crc16_modbus_(const uint8_t *data, size_t length);
+  bool send_frame_(const uint8_t *frame, size_t length, const char *log_label);
+#ifdef AUTOTERM_UART_CRC_BENCHMARK
+  void benchmark_crc_() const;
+#endif
+#ifdef AUTOTERM_UART_CLIMATE
   void evaluate_thermostat_control_(bool force = false);
   void handle_thermostat_status_update_(uint16_t status_code);
   void send_thermostat_cooldown_(uint8_t source, uint8_t temp_byte);
   float clamp_thermostat_target_(float target) const;
   float clamp_thermostat_hys_on_(float value) const;
   float clamp_thermostat_hys_off_(float value) const;
+#endif
 
   void publish_temp_source_select_(uint8_t source);
   uint8_t clamp_temp_source_(uint8_t source) const;
   bool should_force_temp_source_() const;
   uint8_t map_source_to_heater_(uint8_t source) const;
 
-  void advance_runtime_time_(uint32_t now);
   void set_heater_running_state_(bool running);
+  void restore_state_();
+  void snapshot_state_(PersistedState &state) const;
+  void maybe_save_state_(uint32_t now);
+#ifdef AUTOTERM_UART_RUNTIME
+  void advance_runtime_time_(uint32_t now);
   void publish_runtime_hours_(bool force = false);
   void publish_session_runtime_(bool force = false);
   void maybe_save_runtime_hours_(uint32_t now, bool force = false);
-  bool is_heater_active_status_(uint16_t status_code) const;
+#endif
 };
 
+#ifdef AUTOTERM_UART_CLIMATE
 // ===================
 // Climate-Class
 // ===================
@@ -376,7 +1041,16 @@ class AutotermClimate : public climate::Climate {
   void set_thermostat_hysteresis(float hys_on_c, float hys_off_c);
 
   void handle_status_update(uint16_t status_code, float internal_temp);
-  void handle_settings_update(const AutotermUART::Settings &settings, bool from_display);
+  // Übernimmt Modus, Preset, Stufe und Solltemperatur aus bestätigten Settings
+  void handle_settings_update(const AutotermUART::Settings &settings);
+
+  static constexpr const char *PRESETS[] = {"Leistungsmodus", "Heizen", "Heizen+Lüften", "Thermostat"};
+  static constexpr uint8_t NO_PRESET = 0xFF;
+  // Vorläufiger Zustand aus dem Flash, ohne Kommandos an die Heizung
+  void restore_state(climate::ClimateMode mode, uint8_t preset_index, uint8_t level, float target_temp);
+  uint8_t preset_index() const;
+  uint8_t level() const { return fan_level_; }
+  float target_temperature_c() const { return target_temperature_c_; }
 
  protected:
   climate::ClimateTraits traits() override;
@@ -400,13 +1074,12 @@ class AutotermClimate : public climate::Climate {
   uint8_t fan_mode_label_to_level_(const std::string &label) const;
   std::string sanitize_preset_(const std::string &preset) const;
   uint8_t resolve_temp_sensor_() const;
-  climate::ClimateMode deduce_mode_from_settings_(const AutotermUART::Settings &settings) const;
-  std::string deduce_preset_from_settings_(const AutotermUART::Settings &settings) const;
   void apply_state_(climate::ClimateMode mode, const std::string &preset, uint8_t level, float target_temp);
   void update_action_from_status_(uint16_t status_code);
   static std::string preset_from_enum_(climate::ClimatePreset preset);
   static uint8_t fan_level_from_enum_(climate::ClimateFanMode mode, uint8_t fallback_level);
 };
+#endif
 
 // ===================
 // Methodenimplementierungen
@@ -418,6 +1091,7 @@ void AutotermFanLevelNumber::control(float value) {
   if (parent_) parent_->send_fan_mode(true, (int)value);
 }
 
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
 void AutotermTempSourceSelect::set_parent(AutotermUART *parent) {
   parent_ = parent;
   this->traits.set_options({"Intern", "Panel", "Extern", "Home Assistant"});
@@ -458,7 +1132,9 @@ void AutotermTempSourceSelect::control(const std::string &value) {
   }
   parent_->set_temp_source_from_select(src);
 }
+#endif
 
+#ifdef AUTOTERM_UART_RUNTIME
 void AutotermUART::set_runtime_hours_sensor(Sensor *s) {
   runtime_hours_sensor_ = s;
   if (runtime_hours_sensor_ != nullptr && runtime_loaded_)
@@ -470,7 +1146,9 @@ void AutotermUART::set_session_runtime_sensor(Sensor *s) {
   if (session_runtime_sensor_ != nullptr && runtime_tracking_initialized_)
     publish_session_runtime_(true);
 }
+#endif
 
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
 void AutotermUART::set_panel_temp_override_sensor(Sensor *s) {
   panel_temp_override_sensor_ = s;
   if (panel_temp_override_sensor_ != nullptr) {
@@ -481,7 +1159,9 @@ void AutotermUART::set_panel_temp_override_sensor(Sensor *s) {
       panel_temp_override_value_c_ = panel_temp_override_sensor_->state;
   }
 }
+#endif
 
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
 void AutotermUART::set_temp_source_select(AutotermTempSourceSelect *select) {
   temp_source_select_ = select;
   if (temp_source_select_ != nullptr) {
@@ -501,10 +1181,14 @@ void AutotermUART::set_temp_source_from_select(uint8_t source) {
   publish_temp_source_select_(clamped);
   if (changed) {
     ESP_LOGI("autoterm_uart", "Temperature source set via select to %u", static_cast<unsigned>(clamped));
+    request_state_save();
+#ifdef AUTOTERM_UART_CLIMATE
     if (climate_ != nullptr)
       climate_->publish_state();
+#endif
   }
 }
+#endif
 
 void AutotermUART::apply_temp_source_from_settings(uint8_t source) {
   uint8_t clamped = clamp_temp_source_(source);
@@ -542,6 +1226,122 @@ float AutotermUART::get_temperature_for_source(uint8_t source) const {
   return NAN;
 }
 
+void AutotermUART::set_heater_running_state_(bool running) {
+  if (heater_running_ == running)
+    return;
+
+#ifdef AUTOTERM_UART_RUNTIME
+  uint32_t now = millis();
+  advance_runtime_time_(now);
+  heater_running_ = running;
+  last_runtime_millis_ = now;
+
+  if (heater_running_) {
+    session_runtime_hours_ = 0.0f;
+    session_runtime_last_published_ = NAN;
+    publish_session_runtime_(true);
+  } else {
+    publish_runtime_hours_(true);
+    publish_session_runtime_(true);
+    maybe_save_runtime_hours_(now, true);
+  }
+#else
+  heater_running_ = running;
+#endif
+}
+
+void AutotermUART::request_state_save() {
+  if (!state_dirty_)
+    state_dirty_since_millis_ = millis();
+  state_dirty_ = true;
+}
+
+void AutotermUART::snapshot_state_(PersistedState &state) const {
+  // Auch die Füllbytes nullen, sonst schlägt der memcmp-Vergleich fehl
+  std::memset(static_cast<void *>(&state), 0, sizeof(state));
+  state.version = PERSISTED_STATE_VERSION;
+  state.settings_valid = settings_valid_ || settings_restored_;
+  state.settings = settings_;
+  state.manual_temp_source = manual_temp_source_active_ ? manual_temp_source_value_ : 0;
+  state.climate_preset = 0xFF;
+#ifdef AUTOTERM_UART_CLIMATE
+  if (climate_ != nullptr) {
+    state.climate_mode = static_cast<uint8_t>(climate_->mode);
+    state.climate_preset = climate_->preset_index();
+    state.climate_level = climate_->level();
+    state.climate_target_c = climate_->target_temperature_c();
+  }
+  const autoterm::ThermostatConfig &thermostat = thermostat_.config();
+  state.thermostat_active = thermostat_.active();
+  state.thermostat_level = thermostat.level;
+  state.thermostat_sensor_source = thermostat_sensor_source_;
+  state.thermostat_target_c = thermostat.target_c;
+  state.thermostat_hys_on_c = thermostat.hys_on_c;
+  state.thermostat_hys_off_c = thermostat.hys_off_c;
+#endif
+}
+
+void AutotermUART::maybe_save_state_(uint32_t now) {
+  if (!state_dirty_ || !state_storage_initialized_ || (now - state_dirty_since_millis_) < STATE_SAVE_DELAY_MS)
+    return;
+  state_dirty_ = false;
+  PersistedState state;
+  snapshot_state_(state);
+  if (std::memcmp(&state, &saved_state_, sizeof(state)) == 0)
+    return;
+  if (state_pref_.save(&state))
+    saved_state_ = state;
+}
+
+// Übernimmt den zuletzt gespeicherten Zustand vorläufig, bis die Heizung antwortet
+void AutotermUART::restore_state_() {
+  if (global_preferences == nullptr)
+    return;
+  state_pref_ = global_preferences->make_preference<PersistedState>(fnv1_hash("autoterm_uart_state"));
+  state_storage_initialized_ = true;
+
+  PersistedState state;
+  if (!state_pref_.load(&state) || state.version != PERSISTED_STATE_VERSION)
+    return;
+  saved_state_ = state;
+
+  if (state.settings_valid && !settings_valid_) {
+    settings_ = state.settings;
+    settings_restored_ = true;
+  }
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
+  if (state.manual_temp_source >= 1 && state.manual_temp_source <= 4) {
+    manual_temp_source_active_ = true;
+    manual_temp_source_value_ = state.manual_temp_source;
+  }
+#endif
+  if (manual_temp_source_active_)
+    publish_temp_source_select_(manual_temp_source_value_);
+  else if (settings_restored_)
+    publish_temp_source_select_(clamp_temp_source_(settings_.temperature_source));
+
+#ifdef AUTOTERM_UART_CLIMATE
+  if (state.thermostat_active) {
+    autoterm::ThermostatConfig config;
+    config.target_c = clamp_thermostat_target_(state.thermostat_target_c);
+    config.hys_on_c = clamp_thermostat_hys_on_(state.thermostat_hys_on_c);
+    config.hys_off_c = clamp_thermostat_hys_off_(state.thermostat_hys_off_c);
+    config.level = std::min<uint8_t>(state.thermostat_level, 9);
+    thermostat_sensor_source_ = clamp_temp_source_(state.thermostat_sensor_source);
+    thermostat_.restore(config);
+  }
+  if (climate_ != nullptr && state.climate_preset != AutotermClimate::NO_PRESET) {
+    climate_->restore_state(static_cast<climate::ClimateMode>(state.climate_mode), state.climate_preset,
+                            state.climate_level, state.climate_target_c);
+  }
+#endif
+  // restore_state() löst selbst keinen erneuten Speichervorgang aus
+  state_dirty_ = false;
+  ESP_LOGI("autoterm_uart", "Restored cached state (settings %s, temp source %u)",
+           settings_restored_ ? "provisional" : "none", static_cast<unsigned>(state.manual_temp_source));
+}
+
+#ifdef AUTOTERM_UART_RUNTIME
 void AutotermUART::advance_runtime_time_(uint32_t now) {
   if (!runtime_tracking_initialized_) {
     last_runtime_millis_ = now;
@@ -562,25 +1362,6 @@ void AutotermUART::advance_runtime_time_(uint32_t now) {
   publish_session_runtime_();
 }
 
-void AutotermUART::set_heater_running_state_(bool running) {
-  if (heater_running_ == running)
-    return;
-
-  uint32_t now = millis();
-  advance_runtime_time_(now);
-  heater_running_ = running;
-  last_runtime_millis_ = now;
-
-  if (heater_running_) {
-    session_runtime_hours_ = 0.0f;
-    session_runtime_last_published_ = NAN;
-    publish_session_runtime_(true);
-  } else {
-    publish_runtime_hours_(true);
-    publish_session_runtime_(true);
-    maybe_save_runtime_hours_(now, true);
-  }
-}
 
 void AutotermUART::publish_runtime_hours_(bool force) {
   if (!runtime_loaded_ || runtime_hours_sensor_ == nullptr)
@@ -629,61 +1410,161 @@ void AutotermUART::maybe_save_runtime_hours_(uint32_t now, bool force) {
     last_runtime_save_millis_ = now;
   }
 }
+#endif
 
-bool AutotermUART::is_heater_active_status_(uint16_t status_code) const {
-  if (status_code == 0x0000 || status_code == 0x0001)
+bool AutotermUART::may_rewrite_frame(const autoterm::BridgeChannel &channel, uint8_t device, uint8_t command) {
+  if (!channel.from_display())
     return false;
-  return true;
+  if (command == autoterm::CMD_PANEL_TEMPERATURE && panel_override_byte_.load(std::memory_order_relaxed) >= 0)
+    return true;
+  if (device == autoterm::DEVICE_CONTROLLER && (command == autoterm::CMD_START || command == autoterm::CMD_SETTINGS) &&
+      forced_source_byte_.load(std::memory_order_relaxed) >= 0)
+    return true;
+  return false;
 }
 
-void AutotermUART::process_frame_(std::vector<uint8_t> frame, UARTComponent *dst, const char *tag, bool from_display) {
-  if (frame.empty())
-    return;
+bool AutotermUART::rewrite_frame(const autoterm::BridgeChannel &channel, uint8_t *frame, size_t length) {
+  if (!channel.from_display())
+    return false;
 
-  bool valid = validate_crc(frame);
-  std::vector<uint8_t> outgoing = frame;
-
-  if (valid && from_display) {
-    if (is_panel_temperature_frame_(outgoing) && should_override_panel_temperature_()) {
-      if (outgoing.size() > 5) {
-        uint8_t original_byte = outgoing[5];
-        uint8_t override_byte = compute_override_temperature_byte_();
-        if (override_byte != original_byte) {
-          outgoing[5] = override_byte;
-          update_crc_(outgoing);
-          ESP_LOGD("autoterm_uart", "Panel temp override active: %u -> %u (source %.1f°C)",
-                   static_cast<unsigned>(original_byte),
-                   static_cast<unsigned>(override_byte),
-                   panel_temp_override_value_c_);
-        }
+  autoterm::FrameView view(frame, length);
+  if (!view.valid())
+    return false;
+
+  // Umschreiben direkt im gehaltenen Frame, die CRC wird inkrementell korrigiert
+  bool changed = false;
+  int16_t override_byte = panel_override_byte_.load(std::memory_order_relaxed);
+  if (override_byte >= 0 && autoterm::PanelTempFrame::matches(view)) {
+    uint8_t original_byte = autoterm::PanelTempFrame(view).temperature();
+    if (override_byte != original_byte) {
+      autoterm::patch_frame_byte(frame, length, autoterm::PanelTempFrame::TEMPERATURE_INDEX,
+                                 static_cast<uint8_t>(override_byte));
+      changed = true;
+      // Aus dem Bridge-Task wird nicht geloggt, der Zähler "rewritten" genügt
+      if (!bridge_task_running_()) {
+        ESP_LOGD("autoterm_uart", "Panel temp override active: %u -> %u (source %.1f°C)",
+                 static_cast<unsigned>(original_byte), static_cast<unsigned>(override_byte),
+                 panel_temp_override_value_c_);
       }
     }
-    apply_temp_source_override_(outgoing);
+  }
+  if (apply_temp_source_override_(view, frame))
+    changed = true;
+  return changed;
+}
+
+void AutotermUART::on_frame(const autoterm::BridgeChannel &channel, const uint8_t *frame, size_t length,
+                            bool crc_valid) {
+  if (first_forward_millis_.load(std::memory_order_relaxed) == 0)
+    first_forward_millis_.store(std::max<uint32_t>(1, millis()), std::memory_order_relaxed);
+#ifdef AUTOTERM_UART_BRIDGE_TASK
+  if (bridge_task_running_()) {
+    // Im Bridge-Task nur kopieren; ausgewertet und veröffentlicht wird im Hauptloop
+    BridgeFrame entry;
+    entry.time_ms = millis();
+    entry.length = static_cast<uint8_t>(std::min(length, sizeof(entry.data)));
+    entry.from_display = channel.from_display();
+    entry.crc_valid = crc_valid;
+    std::copy(frame, frame + entry.length, entry.data);
+    if (!bridge_frames_.push(entry))
+      bridge_frame_drops_.add();
+    return;
+  }
+#endif
+  handle_frame_(channel, frame, length, crc_valid, millis());
+}
+
+void AutotermUART::handle_frame_(const autoterm::BridgeChannel &channel, const uint8_t *frame, size_t length,
+                                 bool crc_valid, uint32_t now) {
+  ProfileMark frame_start = profile_start_();
+  // Jeder Frame des Bedienteils erwartet eine Antwort der Heizung
+  if (channel.from_display()) {
+    command_scheduler_.note_request(now);
+    if (display_presence_.on_frame(now) == autoterm::DisplayEvent::CONNECTED)
+      on_display_connected_(now);
+  } else {
+    command_scheduler_.note_response(now);
   }
 
-  if (dst != nullptr && !outgoing.empty()) {
-    dst->write_array(outgoing.data(), outgoing.size());
-    dst->flush();
+  if (!crc_valid) {
+    ESP_LOGW("autoterm_uart", "[%s] CRC falsch, weitergeleitet", channel.tag());
+    return;
   }
 
-  if (!valid) {
-    ESP_LOGW("autoterm_uart", "[%s] CRC falsch, weitergeleitet", tag);
+  autoterm::FrameView view(frame, length);
+  if (!view.valid())
+    return;
+
+  if (channel.from_display())
+    request_tracker_.on_request(frame, length, now, false, nullptr);
+  else
+    request_tracker_.on_response(view.command(), now);
+
+  trace_(autoterm::TraceKind::FRAME, channel.tag(), frame, length);
+  dispatch_frame_(view, channel.from_display());
+  profile_end_(LOOP_STAGE_FRAME, frame_start);
+}
+
+const AutotermUART::FrameRoute AutotermUART::FRAME_ROUTES[3] = {
+    {autoterm::CMD_STATUS, &autoterm::StatusFrame::matches, &AutotermUART::on_status_frame_,
+     LOOP_STAGE_PARSE_STATUS},
+    {autoterm::CMD_SETTINGS, &autoterm::SettingsFrame::matches, &AutotermUART::on_settings_frame_,
+     LOOP_STAGE_PARSE_SETTINGS},
+    {autoterm::CMD_PANEL_TEMPERATURE, &autoterm::PanelTempFrame::matches, &AutotermUART::on_panel_temp_frame_,
+     LOOP_STAGE_COUNT},
+};
+
+void AutotermUART::dispatch_frame_(const autoterm::FrameView &frame, bool from_display) {
+  for (const FrameRoute &route : FRAME_ROUTES) {
+    if (route.command != frame.command() || !route.matches(frame))
+      continue;
+    ProfileMark stage_start = profile_start_();
+    (this->*route.handle)(frame, from_display);
+    if (route.stage != LOOP_STAGE_COUNT)
+      profile_end_(route.stage, stage_start);
     return;
   }
+}
 
-  if (is_panel_temperature_frame_(outgoing))
-    handle_panel_temperature_frame_(outgoing);
+void AutotermUART::on_status_frame_(const autoterm::FrameView &frame, bool) {
+  parse_status(autoterm::StatusFrame(frame));
+}
+
+void AutotermUART::on_settings_frame_(const autoterm::FrameView &frame, bool) {
+  parse_settings(autoterm::SettingsFrame(frame));
+}
 
-  log_frame(tag, outgoing);
-  parse_status(outgoing);
-  parse_settings(outgoing, from_display);
+void AutotermUART::on_panel_temp_frame_(const autoterm::FrameView &frame, bool) {
+  handle_panel_temperature_frame_(autoterm::PanelTempFrame(frame));
+}
+
+void AutotermUART::dump_loop_profile() {
+#ifdef AUTOTERM_UART_PROFILE
+  static const char *const STAGE_NAMES[LOOP_STAGE_COUNT] = {
+      "loop", "forward display→heater", "forward heater→display", "frame", "parse_status",
+      "parse_settings", "commands/tx", "poll", "runtime", "thermostat", "trace"};
+  ESP_LOGI("autoterm_uart", "Loop profile (µs):");
+  for (uint8_t stage = 0; stage < LOOP_STAGE_COUNT; stage++) {
+    const StageHistogram &histogram = loop_profile_[stage];
+    ESP_LOGI("autoterm_uart", "  %-24s n=%u min=%u avg=%u max=%u p99=%u", STAGE_NAMES[stage],
+             static_cast<unsigned>(histogram.count()), static_cast<unsigned>(histogram.min()),
+             static_cast<unsigned>(histogram.average()), static_cast<unsigned>(histogram.max()),
+             static_cast<unsigned>(histogram.percentile(99)));
+  }
+#else
+  ESP_LOGW("autoterm_uart", "Loop profiler not enabled (loop_profiler in YAML)");
+#endif
 }
 
 void AutotermUART::publish_temp_source_select_(uint8_t source) {
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
   if (temp_source_select_ != nullptr) {
     uint8_t clamped = clamp_temp_source_(source);
     temp_source_select_->publish_for_source(clamped);
   }
+#else
+  (void) source;
+#endif
 }
 
 uint8_t AutotermUART::clamp_temp_source_(uint8_t source) const {
@@ -693,49 +1574,39 @@ uint8_t AutotermUART::clamp_temp_source_(uint8_t source) const {
 }
 
 bool AutotermUART::should_force_temp_source_() const {
+#ifdef AUTOTERM_UART_TEMP_SOURCE_SELECT
   return manual_temp_source_active_ && manual_temp_source_value_ >= 1 && manual_temp_source_value_ <= 4;
+#else
+  // Ohne Select wird die Quelle nie manuell festgelegt
+  return false;
+#endif
 }
 
 uint8_t AutotermUART::map_source_to_heater_(uint8_t source) const {
-  switch (clamp_temp_source_(source)) {
-    case 1: return 0x01;
-    case 2: return 0x02;
-    case 3: return 0x03;
-    case 4: return 0x02;  // Home Assistant meldet sich gegenüber der Heizung als Panelsensor
-    default: return 0x01;
-  }
+  return autoterm::map_temp_source_to_heater(clamp_temp_source_(source));
 }
 
-void AutotermUART::apply_temp_source_override_(std::vector<uint8_t> &frame) {
-  if (!should_force_temp_source_())
-    return;
-
-  if (frame.size() < 7)
-    return;
-  if (frame[0] != 0xAA || frame[1] != 0x03)
-    return;
-
-  uint8_t command = frame[4];
-  if (command != 0x01 && command != 0x02)
-    return;
-
-  size_t payload_index = 5;
-  if (frame.size() <= payload_index + 2)
-    return;
+bool AutotermUART::apply_temp_source_override_(const autoterm::FrameView &view, uint8_t *frame) {
+  int16_t forced = forced_source_byte_.load(std::memory_order_relaxed);
+  if (forced < 0 || !autoterm::CommandFrame::matches(view))
+    return false;
 
-  uint8_t desired = map_source_to_heater_(manual_temp_source_value_);
-  uint8_t current = frame[payload_index + 2];
+  uint8_t desired = static_cast<uint8_t>(forced);
+  uint8_t current = autoterm::CommandFrame(view).temperature_source();
   if (current == desired)
-    return;
+    return false;
 
-  frame[payload_index + 2] = desired;
-  update_crc_(frame);
+  autoterm::patch_frame_byte(frame, view.length(), autoterm::CommandFrame::TEMP_SOURCE_INDEX, desired);
 
-  ESP_LOGD("autoterm_uart", "Temperature source override active: %u -> %u",
-           static_cast<unsigned>(current), static_cast<unsigned>(desired));
+  if (!bridge_task_running_()) {
+    ESP_LOGD("autoterm_uart", "Temperature source override active: %u -> %u", static_cast<unsigned>(current),
+             static_cast<unsigned>(desired));
+  }
+  return true;
 }
 
 bool AutotermUART::should_override_panel_temperature_() const {
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
   if (!std::isfinite(panel_temp_override_value_c_))
     return false;
 
@@ -748,6 +1619,9 @@ bool AutotermUART::should_override_panel_temperature_() const {
   if (source != 4)
     return false;
   return true;
+#else
+  return false;
+#endif
 }
 
 uint8_t AutotermUART::compute_override_temperature_byte_() const {
@@ -758,125 +1632,107 @@ uint8_t AutotermUART::compute_override_temperature_byte_() const {
   return static_cast<uint8_t>(std::round(value));
 }
 
-void AutotermUART::update_crc_(std::vector<uint8_t> &frame) {
-  if (frame.size() < 3)
-    return;
-  uint16_t crc = crc16_modbus_(frame.data(), frame.size() - 2);
-  frame[frame.size() - 2] = (crc >> 8) & 0xFF;
-  frame[frame.size() - 1] = crc & 0xFF;
-}
-
 // ===================
 // Bestehende Methoden
 // ===================
-void AutotermUART::parse_status(const std::vector<uint8_t> &data) {
-  if (data.size() < 24) return;
-  if (data[1] != 0x04 || data[4] != 0x0F) return;
-
-  const uint8_t *p = &data[5];
-
-  uint8_t s_hi = p[0];
-  uint8_t s_lo = p[1];
-  uint16_t status_code = (static_cast<uint16_t>(s_hi) << 8) | s_lo;
-
-  uint8_t fan_set_raw = p[11];
-  uint8_t fan_actual_raw = p[12];
-  uint8_t pump_raw = p[14];
-
-  float status_val = s_hi + (s_lo / 10.0f);
-  float internal_temp = (p[3] > 127 ? p[3] - 255 : p[3]);
-  float external_temp = (p[4] > 127 ? p[4] - 255 : p[4]);
-  float voltage = p[6] / 10.0f;
-
-  uint16_t heater_temp_raw = (static_cast<uint16_t>(p[7]) << 8) | p[8];
-  float heater_temp = NAN;
-  if (heater_temp_raw != 0xFFFF)
-    heater_temp = (static_cast<float>(heater_temp_raw) - 0x100)/2;
-
-  float fan_set_rpm = fan_set_raw * 60.0f;
-  float fan_actual_rpm = fan_actual_raw * 60.0f;
-  float pump_freq = pump_raw / 100.0f;
-
-  const char *status_txt = "Unbekannt";
-  switch (status_code) {
-    case 0x0001: status_txt = "Standby"; break;
-    case 0x0100: status_txt = "Flammensensor kühlt"; break;
-    case 0x0101: status_txt = "Lüftung"; break;
-    case 0x0200: status_txt = "Heizung wird vorbereitet"; break;
-    case 0x0201: status_txt = "Glühkerze heizt"; break;
-    case 0x0202: status_txt = "Zündung 1"; break;
-    case 0x0203: status_txt = "Zündung 2"; break;
-    case 0x0204: status_txt = "Brennkammer heizt"; break;
-    case 0x0300: status_txt = "Heizen"; break;
-    case 0x0323: status_txt = "Nur Lüfter"; break;
-    case 0x0304: status_txt = "Kühlt ab"; break;
-    case 0x0305: status_txt = "Nachlauf-Lüftung"; break;
-    case 0x0400: status_txt = "Herunterfahren"; break;
-    default: {
-      static char unknown_buf[32];
-      snprintf(unknown_buf, sizeof(unknown_buf), "Unbekannt (0x%02X%02X)", s_hi, s_lo);
-      status_txt = unknown_buf;
-      break;
-    }
+void AutotermUART::parse_status(const autoterm::StatusFrame &frame) {
+  autoterm::Status status;
+  frame.decode(status);
+
+  uint16_t status_code = status.code;
+  uint8_t s_hi = status_code >> 8;
+  uint8_t s_lo = status_code & 0xFF;
+
+  const char *status_txt = autoterm::status_text(status_code);
+  if (status_txt == nullptr) {
+    static char unknown_buf[32];
+    snprintf(unknown_buf, sizeof(unknown_buf), "Unbekannt (0x%02X%02X)", s_hi, s_lo);
+    status_txt = unknown_buf;
   }
 
   ESP_LOGD("autoterm_uart",
            "Status: %s (0x%02X%02X) | U=%.1fV | Heater %.0f°C | Fan %.0f/%.0f rpm | Pump %.2f Hz",
-           status_txt, s_hi, s_lo, voltage, heater_temp, fan_actual_rpm, fan_set_rpm, pump_freq);
+           status_txt, s_hi, s_lo, status.voltage, status.heater_temp, status.fan_actual_rpm,
+           status.fan_set_rpm, status.pump_frequency);
 
-  set_heater_running_state_(is_heater_active_status_(status_code));
+  set_heater_running_state_(autoterm::is_heater_active_status(status_code));
 
-  if (internal_temp_sensor_) internal_temp_sensor_->publish_state(internal_temp);
-  if (external_temp_sensor_) external_temp_sensor_->publish_state(external_temp);
-  if (heater_temp_sensor_)   heater_temp_sensor_->publish_state(heater_temp);
+  uint32_t now = millis();
+  poll_scheduler_.on_status(status_code, now);
+  publish_filtered_(internal_temp_sensor_, STATUS_SENSOR_INTERNAL_TEMP, status.internal_temp, now);
+  publish_filtered_(external_temp_sensor_, STATUS_SENSOR_EXTERNAL_TEMP, status.external_temp, now);
+  publish_filtered_(heater_temp_sensor_, STATUS_SENSOR_HEATER_TEMP, status.heater_temp, now);
 
-  last_internal_temp_c_ = internal_temp;
-  last_external_temp_c_ = external_temp;
+  last_internal_temp_c_ = status.internal_temp;
+  last_external_temp_c_ = status.external_temp;
 
+#ifdef AUTOTERM_UART_CLIMATE
   handle_thermostat_status_update_(status_code);
-  if (thermostat_active_ && !thermostat_waiting_for_idle_)
+  if (thermostat_.active() && !thermostat_.waiting_for_idle())
     evaluate_thermostat_control_(true);
+#endif
+
+  publish_filtered_(voltage_sensor_, STATUS_SENSOR_VOLTAGE, status.voltage, now);
+  publish_filtered_(status_sensor_, STATUS_SENSOR_STATUS, status.value, now);
+  publish_filtered_(fan_speed_set_sensor_, STATUS_SENSOR_FAN_SPEED_SET, status.fan_set_rpm, now);
+  publish_filtered_(fan_speed_actual_sensor_, STATUS_SENSOR_FAN_SPEED_ACTUAL, status.fan_actual_rpm, now);
+  publish_filtered_(pump_frequency_sensor_, STATUS_SENSOR_PUMP_FREQUENCY, status.pump_frequency, now);
+
+  // Klartext nur bei geändertem Statuscode
+  if (status_text_sensor_) {
+    if (!status_text_published_ || status_code != status_text_code_) {
+      status_text_sensor_->publish_state(status_txt);
+      status_text_code_ = status_code;
+      status_text_published_ = true;
+      publishes_sent_++;
+    } else {
+      publishes_suppressed_++;
+    }
+  }
 
-  if (voltage_sensor_)       voltage_sensor_->publish_state(voltage);
-  if (status_sensor_)        status_sensor_->publish_state(status_val);
-  if (status_text_sensor_)   status_text_sensor_->publish_state(status_txt);
-  if (fan_speed_set_sensor_)    fan_speed_set_sensor_->publish_state(fan_set_rpm);
-  if (fan_speed_actual_sensor_) fan_speed_actual_sensor_->publish_state(fan_actual_rpm);
-  if (pump_frequency_sensor_)   pump_frequency_sensor_->publish_state(pump_freq);
-
-  if (climate_) climate_->handle_status_update(status_code, internal_temp);
+#ifdef AUTOTERM_UART_CLIMATE
+  if (climate_) climate_->handle_status_update(status_code, status.internal_temp);
+#endif
 }
 
-void AutotermUART::parse_settings(const std::vector<uint8_t> &data, bool from_display) {
-  if (data.size() < 13) return;
-
-  if (data.size() >= 5 && data[1] == 0x04 && data[4] == 0x02) {
-    const uint8_t *p = &data[5];
-    uint8_t use_work_time = p[0];
-    uint8_t work_time = p[1];
-    uint8_t temp_source = p[2];
-    uint8_t set_temp = p[3];
-    uint8_t wait_mode = p[4];
-    uint8_t power_level = p[5];
-
-    ESP_LOGD("autoterm_uart",
-      "Settings: use_work_time=%d work_time=%d temp_src=%d set_temp=%d wait_mode=%d level=%d",
-      use_work_time, work_time, temp_source, set_temp, wait_mode, power_level);
-
-    Settings s{};
-    s.use_work_time = use_work_time;
-    s.work_time = work_time;
-    s.temperature_source = temp_source;
-    s.set_temperature = set_temp;
-    s.wait_mode = wait_mode;
-    s.power_level = power_level;
+void AutotermUART::publish_filtered_(Sensor *sensor, StatusSensor index, float value, uint32_t now) {
+  if (sensor == nullptr)
+    return;
+  autoterm::PublishFilter &filter = publish_filters_[index];
+  if (!filter.should_publish(value, now, publish_heartbeat_ms_)) {
+    publishes_suppressed_++;
+    return;
+  }
+  sensor->publish_state(value);
+  filter.mark_published(value, now);
+  publishes_sent_++;
+}
 
-    settings_ = s;
-    settings_valid_ = true;
+void AutotermUART::parse_settings(const autoterm::SettingsFrame &frame) {
+  Settings s{};
+  frame.decode(s);
 
-    apply_temp_source_from_settings(s.temperature_source);
-    if (climate_) climate_->handle_settings_update(settings_, from_display);
-  }
+  ESP_LOGD("autoterm_uart",
+    "Settings: use_work_time=%d work_time=%d temp_src=%d set_temp=%d wait_mode=%d level=%d",
+    s.use_work_time, s.work_time, s.temperature_source, s.set_temperature, s.wait_mode, s.power_level);
+
+  // Die erste Antwort der Heizung bestätigt oder ersetzt den vorläufigen Zustand
+  bool first_confirmation = !settings_valid_ || settings_restored_;
+  if (settings_restored_ && std::memcmp(&settings_, &s, sizeof(s)) != 0)
+    ESP_LOGI("autoterm_uart", "Heater settings differ from cached state, using heater values");
+  settings_restored_ = false;
+  if (first_confirmation || std::memcmp(&settings_, &s, sizeof(s)) != 0)
+    request_state_save();
+  settings_ = s;
+  settings_valid_ = true;
+  command_scheduler_.note_settings_confirmed();
+  poll_scheduler_.on_settings(millis());
+
+  apply_temp_source_from_settings(s.temperature_source);
+#ifdef AUTOTERM_UART_CLIMATE
+  if (climate_ != nullptr && first_confirmation)
+    climate_->handle_settings_update(settings_);
+#endif
 }
 
 void AutotermUART::send_fan_mode(bool on, int level) {
@@ -888,257 +1744,189 @@ void AutotermUART::send_fan_mode(bool on, int level) {
   send_fan_only(static_cast<uint8_t>(clamped));
 }
 
-bool AutotermUART::is_panel_temperature_frame_(const std::vector<uint8_t> &frame) const {
-  if (frame.size() < 8) return false;
-  if (frame[0] != 0xAA) return false;
-  if (frame[1] != 0x03 && frame[1] != 0x04) return false;
-  if (frame[2] != 0x01) return false;
-  if (frame[3] != 0x00) return false;
-  if (frame[4] != 0x11) return false;
-  return true;
-}
-
-void AutotermUART::handle_panel_temperature_frame_(const std::vector<uint8_t> &frame) {
-  if (frame.size() < 6) return;
-  uint8_t raw = frame[5];
-  float temperature_c = static_cast<float>(raw);
+void AutotermUART::handle_panel_temperature_frame_(const autoterm::PanelTempFrame &frame) {
+  float temperature_c = static_cast<float>(frame.temperature());
   panel_temp_last_value_c_ = temperature_c;
   if (panel_temp_sensor_ != nullptr)
     panel_temp_sensor_->publish_state(temperature_c);
 }
 
-uint16_t AutotermUART::crc16_modbus_(const uint8_t *data, size_t length) {
-  uint16_t crc = 0xFFFF;
-  for (size_t pos = 0; pos < length; pos++) {
-    crc ^= data[pos];
-    for (int i = 0; i < 8; i++) {
-      if (crc & 0x0001)
-        crc = (crc >> 1) ^ 0xA001;
-      else
-        crc >>= 1;
-    }
+#ifdef AUTOTERM_UART_CRC_BENCHMARK
+// Vergleicht die Tabellen-CRC mit der früheren bitweisen Schleife
+void AutotermUART::benchmark_crc_() const {
+  static const uint8_t frame[] = {0xAA, 0x04, 0x13, 0x00, 0x0F, 0x00, 0x01, 0x00, 0x13, 0x7F, 0x00, 0x84,
+                                  0x01, 0x26, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x66};
+  static constexpr uint32_t iterations = 2000;
+  volatile uint16_t sink = 0;
+
+  uint32_t start = micros();
+  for (uint32_t n = 0; n < iterations; n++) {
+    uint16_t crc = autoterm::CRC16_MODBUS_INIT;
+    for (uint8_t byte : frame)
+      crc = autoterm::crc16_modbus_bitwise_update(crc, byte);
+    sink = crc;
   }
-  return crc;
-}
+  uint32_t bitwise_us = micros() - start;
+
+  start = micros();
+  for (uint32_t n = 0; n < iterations; n++)
+    sink = autoterm::crc16_modbus(frame, sizeof(frame));
+  uint32_t table_us = micros() - start;
+
+  start = micros();
+  for (uint32_t n = 0; n < iterations; n++)
+    sink = autoterm::crc16_modbus_patch(sink, frame[5], static_cast<uint8_t>(n), sizeof(frame) - 6);
+  uint32_t patch_us = micros() - start;
+  (void) sink;
 
-uint16_t AutotermUART::append_crc_(std::vector<uint8_t> &frame) {
-  uint16_t crc = crc16_modbus_(frame.data(), frame.size());
-  frame.push_back((crc >> 8) & 0xFF);
-  frame.push_back(crc & 0xFF);
-  return crc;
+  ESP_LOGCONFIG("autoterm_uart", "  CRC benchmark (%u x %u bytes): bitwise=%uus table=%uus patch=%uus",
+                static_cast<unsigned>(iterations), static_cast<unsigned>(sizeof(frame)),
+                static_cast<unsigned>(bitwise_us), static_cast<unsigned>(table_us),
+                static_cast<unsigned>(patch_us));
 }
+#endif
 
-bool AutotermUART::send_command_(uint8_t command, const std::vector<uint8_t> &payload, const char *log_label) {
+bool AutotermUART::send_frame_(const uint8_t *frame, size_t length, const char *log_label) {
+  uint8_t command = length > 4 ? frame[4] : 0;
   if (!uart_heater_) {
     ESP_LOGW("autoterm_uart", "UART heater not configured, skipping command 0x%02X", command);
     return false;
   }
-  std::vector<uint8_t> frame;
-  frame.reserve(5 + payload.size() + 2);
-  frame.push_back(0xAA);
-  frame.push_back(0x03);
-  frame.push_back(static_cast<uint8_t>(payload.size()));
-  frame.push_back(0x00);
-  frame.push_back(command);
-  frame.insert(frame.end(), payload.begin(), payload.end());
-  uint16_t crc = append_crc_(frame);
-
-  uart_heater_->write_array(frame);
-  uart_heater_->flush();
-
-  std::string payload_hex;
-  char temp[4];
-  for (auto byte : payload) {
-    snprintf(temp, sizeof(temp), "%02X", byte);
-    payload_hex += temp;
-    payload_hex += ' ';
-  }
-  if (!payload_hex.empty())
-    payload_hex.pop_back();
-
-  ESP_LOGD("autoterm_uart", "Sent %s (cmd=0x%02X len=%u payload=[%s] crc=%04X)",
-           log_label != nullptr ? log_label : "frame",
-           command, static_cast<unsigned>(payload.size()), payload_hex.c_str(), crc);
+
+  switch (command_scheduler_.submit(frame, length, log_label, settings_valid_ ? &settings_ : nullptr)) {
+    case autoterm::CommandScheduler::Submit::FULL:
+      ESP_LOGW("autoterm_uart", "Command queue full, dropping command 0x%02X", command);
+      return false;
+    case autoterm::CommandScheduler::Submit::REDUNDANT:
+      ESP_LOGD("autoterm_uart", "Command 0x%02X matches confirmed settings, skipped", command);
+      break;
+    case autoterm::CommandScheduler::Submit::COALESCED:
+      ESP_LOGV("autoterm_uart", "Command 0x%02X replaces pending command", command);
+      break;
+    case autoterm::CommandScheduler::Submit::QUEUED:
+      break;
+  }
+  service_commands_();
   return true;
 }
 
 void AutotermUART::send_standby() {
-  send_command_(0x03, {}, "mode.standby");
+  send_frame_(autoterm::STANDBY_FRAME.data(), autoterm::STANDBY_FRAME.size(), "mode.standby");
 }
 
 void AutotermUART::send_power_mode(bool start, uint8_t level) {
-  uint8_t clamped_level = std::min<uint8_t>(level, 9);
-  std::vector<uint8_t> payload{0xFF, 0xFF, 0x04, 0xFF, 0x02, clamped_level};
-  send_command_(start ? 0x01 : 0x02, payload, start ? "mode.leistungsmodus.start" : "mode.leistungsmodus.set");
+  auto frame = autoterm::power_mode_frame(start, level);
+  send_frame_(frame.data(), frame.size(), start ? "mode.leistungsmodus.start" : "mode.leistungsmodus.set");
 }
 
 void AutotermUART::send_temperature_hold_mode(bool start, uint8_t temp_sensor, uint8_t set_temp) {
-  uint8_t sensor = map_source_to_heater_(temp_sensor);
-  uint8_t temp_byte = std::min<uint8_t>(set_temp, 30);
-  std::vector<uint8_t> payload{0xFF, 0xFF, sensor, temp_byte, 0x02, 0xFF};
-  send_command_(start ? 0x01 : 0x02, payload, start ? "mode.heizen.start" : "mode.heizen.set");
+  auto frame = autoterm::temperature_hold_mode_frame(start, map_source_to_heater_(temp_sensor), set_temp);
+  send_frame_(frame.data(), frame.size(), start ? "mode.heizen.start" : "mode.heizen.set");
 }
 
 void AutotermUART::send_temperature_to_fan_mode(bool start, uint8_t temp_sensor, uint8_t set_temp) {
-  uint8_t sensor = map_source_to_heater_(temp_sensor);
-  uint8_t temp_byte = std::min<uint8_t>(set_temp, 30);
-  std::vector<uint8_t> payload{0xFF, 0xFF, sensor, temp_byte, 0x01, 0xFF};
-  send_command_(start ? 0x01 : 0x02, payload, start ? "mode.heizen_plus_lueften.start" : "mode.heizen_plus_lueften.set");
+  auto frame = autoterm::temperature_to_fan_mode_frame(start, map_source_to_heater_(temp_sensor), set_temp);
+  send_frame_(frame.data(), frame.size(), start ? "mode.heizen_plus_lueften.start" : "mode.heizen_plus_lueften.set");
 }
 
 void AutotermUART::send_fan_only(uint8_t level) {
-  uint8_t clamped_level = std::min<uint8_t>(level, 9);
-  std::vector<uint8_t> payload{0xFF, 0xFF, clamped_level, 0xFF};
-  send_command_(0x23, payload, "mode.fan_only");
+  auto frame = autoterm::fan_only_frame(level);
+  send_frame_(frame.data(), frame.size(), "mode.fan_only");
 }
 
+#ifdef AUTOTERM_UART_CLIMATE
 void AutotermUART::configure_thermostat_mode(float target_c, uint8_t level, uint8_t sensor_source,
                                              float hys_on_c, float hys_off_c) {
-  float clamped_target = clamp_thermostat_target_(target_c);
-  uint8_t clamped_level = std::min<uint8_t>(level, 9);
+  autoterm::ThermostatConfig config;
+  config.target_c = clamp_thermostat_target_(target_c);
+  config.hys_on_c = clamp_thermostat_hys_on_(hys_on_c);
+  config.hys_off_c = clamp_thermostat_hys_off_(hys_off_c);
+  config.level = std::min<uint8_t>(level, 9);
   uint8_t clamped_sensor = clamp_temp_source_(sensor_source);
-  float clamped_hys_on = clamp_thermostat_hys_on_(hys_on_c);
-  float clamped_hys_off = clamp_thermostat_hys_off_(hys_off_c);
 
-  bool was_active = thermostat_active_;
-  bool log_needed = !was_active ||
-                    thermostat_target_c_ != clamped_target ||
-                    thermostat_level_ != clamped_level ||
+  const autoterm::ThermostatConfig &current = thermostat_.config();
+  bool log_needed = !thermostat_.active() ||
+                    current.target_c != config.target_c ||
+                    current.level != config.level ||
                     thermostat_sensor_source_ != clamped_sensor ||
-                    thermostat_hys_on_c_ != clamped_hys_on ||
-                    thermostat_hys_off_c_ != clamped_hys_off;
+                    current.hys_on_c != config.hys_on_c ||
+                    current.hys_off_c != config.hys_off_c;
 
-  thermostat_active_ = true;
-  thermostat_target_c_ = clamped_target;
-  thermostat_level_ = clamped_level;
   thermostat_sensor_source_ = clamped_sensor;
-  thermostat_hys_on_c_ = clamped_hys_on;
-  thermostat_hys_off_c_ = clamped_hys_off;
-
-  if (thermostat_last_sent_level_ == 255)
-    thermostat_last_sent_level_ = thermostat_level_;
-
-  if (thermostat_heating_request_ && thermostat_last_sent_level_ != thermostat_level_) {
-    send_power_mode(false, thermostat_level_);
-    thermostat_last_command_millis_ = millis();
-    thermostat_last_sent_level_ = thermostat_level_;
-  } else if (!thermostat_heating_request_) {
-    thermostat_last_sent_level_ = thermostat_level_;
-  }
+  if (thermostat_.configure(config, millis()) == autoterm::ThermostatAction::ADJUST_LEVEL)
+    send_power_mode(false, config.level);
 
   if (log_needed) {
+    request_state_save();
     ESP_LOGI("autoterm_uart",
              "Thermostat config -> target=%.1f°C level=%u sensor=%u hys_on=%.1f°C hys_off=%.1f°C",
-             thermostat_target_c_, static_cast<unsigned>(thermostat_level_),
+             config.target_c, static_cast<unsigned>(config.level),
              static_cast<unsigned>(thermostat_sensor_source_),
-             thermostat_hys_on_c_, thermostat_hys_off_c_);
+             config.hys_on_c, config.hys_off_c);
   }
 
   evaluate_thermostat_control_(true);
 }
 
 void AutotermUART::disable_thermostat_mode() {
-  if (!thermostat_active_)
+  if (!thermostat_.active())
     return;
   ESP_LOGI("autoterm_uart", "Thermostat mode deactivated");
-  thermostat_active_ = false;
-  thermostat_heating_request_ = false;
-  thermostat_waiting_for_idle_ = false;
-  thermostat_last_sent_level_ = 255;
+  thermostat_.deactivate();
+  request_state_save();
 }
 
 void AutotermUART::evaluate_thermostat_control_(bool force) {
-  if (!thermostat_active_)
+  if (!thermostat_.active())
     return;
 
-  uint32_t now = millis();
-  if (!force && (now - thermostat_last_evaluation_millis_) < 1000) return;
-  thermostat_last_evaluation_millis_ = now;
-
   uint8_t effective_source = get_effective_temp_source();
   if (effective_source != thermostat_sensor_source_)
     thermostat_sensor_source_ = clamp_temp_source_(effective_source);
 
   uint8_t source = thermostat_sensor_source_;
   float current_temp = get_temperature_for_source(source);
-  if (!std::isfinite(current_temp)) return;
-
-  float on_threshold  = thermostat_target_c_ - thermostat_hys_on_c_;
-  float off_threshold = thermostat_target_c_ + thermostat_hys_off_c_;
-
-  if (!thermostat_heating_request_ && !thermostat_waiting_for_idle_) {
-    if (current_temp < on_threshold) {
-      bool command_recent = thermostat_last_command_millis_ != 0 &&
-                            (now - thermostat_last_command_millis_) < 1000;
-      if (command_recent) return;
-
-      bool heater_running_now = heater_running_;
-      if (!heater_running_now) {
-        send_power_mode(true, thermostat_level_);
-        thermostat_last_command_millis_ = millis();
-      } else if (thermostat_last_sent_level_ != thermostat_level_) {
-        send_power_mode(false, thermostat_level_);
-        thermostat_last_command_millis_ = millis();
-      }
-      thermostat_last_sent_level_ = thermostat_level_;
-      thermostat_heating_request_ = true;
+  const autoterm::ThermostatConfig &config = thermostat_.config();
 
-      ESP_LOGI("autoterm_uart",
-               "Thermostat: start heating (temp=%.1f°C target=%.1f°C level=%u)",
-               current_temp, thermostat_target_c_, static_cast<unsigned>(thermostat_level_));
-    }
-  } else if (thermostat_heating_request_) {
-    if (current_temp > off_threshold) {
-      bool command_recent = thermostat_last_command_millis_ != 0 &&
-                            (now - thermostat_last_command_millis_) < 1000;
-      if (command_recent) return;
-
-      float cooldown_target = std::max(0.0f, thermostat_target_c_ - 5.0f);
-      uint8_t temp_byte = static_cast<uint8_t>(std::round(std::min(30.0f, cooldown_target)));
+  switch (thermostat_.evaluate(current_temp, heater_running_, millis(), force)) {
+    case autoterm::ThermostatAction::START:
+      send_power_mode(true, config.level);
+      break;
+    case autoterm::ThermostatAction::SET_LEVEL:
+      send_power_mode(false, config.level);
+      break;
+    case autoterm::ThermostatAction::CLAIM:
+      break;
+    case autoterm::ThermostatAction::COOLDOWN: {
+      uint8_t temp_byte = thermostat_.cooldown_temperature();
       send_thermostat_cooldown_(source, temp_byte);
-
-      thermostat_heating_request_ = false;
-      thermostat_waiting_for_idle_ = true;
-      thermostat_last_command_millis_ = millis();
-
       ESP_LOGI("autoterm_uart",
                "Thermostat: cooling down (temp=%.1f°C target=%.1f°C -> temp_cmd=%u)",
-               current_temp, thermostat_target_c_, static_cast<unsigned>(temp_byte));
-    } else if (thermostat_last_sent_level_ != thermostat_level_ &&
-               (now - thermostat_last_command_millis_) > 1500) {
-      send_power_mode(false, thermostat_level_);
-      thermostat_last_command_millis_ = now;
-      thermostat_last_sent_level_ = thermostat_level_;
-      ESP_LOGD("autoterm_uart", "Thermostat: adjust level to %u",
-               static_cast<unsigned>(thermostat_level_));
+               current_temp, config.target_c, static_cast<unsigned>(temp_byte));
+      return;
     }
+    case autoterm::ThermostatAction::ADJUST_LEVEL:
+      send_power_mode(false, config.level);
+      ESP_LOGD("autoterm_uart", "Thermostat: adjust level to %u", static_cast<unsigned>(config.level));
+      return;
+    default:
+      return;
   }
+  ESP_LOGI("autoterm_uart",
+           "Thermostat: start heating (temp=%.1f°C target=%.1f°C level=%u)",
+           current_temp, config.target_c, static_cast<unsigned>(config.level));
 }
 
 void AutotermUART::handle_thermostat_status_update_(uint16_t status_code) {
-  if (!thermostat_active_)
-    return;
-
-  if (!thermostat_waiting_for_idle_ && !is_heater_active_status_(status_code))
-    thermostat_heating_request_ = false;
-
-  if (thermostat_waiting_for_idle_) {
-    if (status_code == 0x0305 || status_code == 0x0323) {
-      ESP_LOGD("autoterm_uart", "Thermostat: idle ventilation detected, sending standby");
-      send_standby();
-      thermostat_waiting_for_idle_ = false;
-      thermostat_last_command_millis_ = millis();
-    } else if (!is_heater_active_status_(status_code)) {
-      thermostat_waiting_for_idle_ = false;
-    }
+  if (thermostat_.on_status(status_code, millis()) == autoterm::ThermostatAction::STANDBY) {
+    ESP_LOGD("autoterm_uart", "Thermostat: idle ventilation detected, sending standby");
+    send_standby();
   }
 }
 
 void AutotermUART::send_thermostat_cooldown_(uint8_t source, uint8_t temp_byte) {
-  uint8_t sensor = map_source_to_heater_(source);
-  uint8_t clamped_temp = std::min<uint8_t>(temp_byte, 30);
-  std::vector<uint8_t> payload{0xFF, 0xFF, sensor, clamped_temp, 0x01, 0xFF};
-  send_command_(0x02, payload, "mode.thermostat.cooldown");
+  auto frame = autoterm::thermostat_cooldown_frame(map_source_to_heater_(source), temp_byte);
+  send_frame_(frame.data(), frame.size(), "mode.thermostat.cooldown");
 }
 
 float AutotermUART::clamp_thermostat_target_(float target) const {
@@ -1158,35 +1946,38 @@ float AutotermUART::clamp_thermostat_hys_off_(float value) const {
   if (value > 2.0f) return 2.0f;
   return value;
 }
+#endif
 
 void AutotermUART::request_settings() {
-  if (send_command_(0x02, {}, "request.settings"))
-    last_settings_request_millis_ = millis();
+  const auto &frame = autoterm::SETTINGS_REQUEST_FRAME;
+  send_frame_(frame.data(), frame.size(), "request.settings");
 }
 
 void AutotermUART::send_status_request() {
-  if (send_command_(0x0F, {}, "request.status"))
-    last_status_request_millis_ = millis();
+  const auto &frame = autoterm::STATUS_REQUEST_FRAME;
+  send_frame_(frame.data(), frame.size(), "request.status");
 }
 
+#ifdef AUTOTERM_UART_PANEL_OVERRIDE
 void AutotermUART::send_panel_temperature_override_frame_() {
   if (!uart_heater_) return;
   if (!std::isfinite(panel_temp_override_value_c_)) return;
 
   uint8_t temp_byte = compute_override_temperature_byte_();
-  std::vector<uint8_t> frame{0xAA, 0x03, 0x01, 0x00, 0x11, temp_byte};
-  append_crc_(frame);
-  uart_heater_->write_array(frame);
-  uart_heater_->flush();
+  auto frame = autoterm::panel_temperature_frame(temp_byte);
+  if (!send_frame_(frame.data(), frame.size(), "panel.override"))
+    return;
 
   panel_temp_last_value_c_ = panel_temp_override_value_c_;
   if (panel_temp_sensor_ != nullptr)
     panel_temp_sensor_->publish_state(panel_temp_override_value_c_);
 
-  ESP_LOGD("autoterm_uart", "Panel temperature override frame sent: byte=%u (%.1f°C)",
+  ESP_LOGD("autoterm_uart", "Panel temperature override frame queued: byte=%u (%.1f°C)",
            static_cast<unsigned>(temp_byte), panel_temp_override_value_c_);
 }
+#endif
 
+#ifdef AUTOTERM_UART_CLIMATE
 // ===================
 // AutotermClimate Implementierungen
 // ===================
@@ -1262,9 +2053,7 @@ climate::ClimateTraits AutotermClimate::traits() {
       climate::CLIMATE_MODE_AUTO});
 
   // Custom presets & fan modes stored as const char* (flash)
-  static constexpr const char* kPresets[] = {
-      "Leistungsmodus", "Heizen", "Heizen+Lüften", "Thermostat"};
-  traits.set_supported_custom_presets(kPresets);
+  traits.set_supported_custom_presets(PRESETS);
 
   static constexpr const char* kFanModes[] = {
       "Stufe 0","Stufe 1","Stufe 2","Stufe 3","Stufe 4",
@@ -1415,14 +2204,48 @@ void AutotermClimate::handle_status_update(uint16_t status_code, float internal_
     this->publish_state();
 }
 
-void AutotermClimate::handle_settings_update(const AutotermUART::Settings &settings, bool from_display) {
-  if (!from_display)
+void AutotermClimate::restore_state(climate::ClimateMode mode, uint8_t preset_index, uint8_t level,
+                                    float target_temp) {
+  std::string preset = preset_index < sizeof(PRESETS) / sizeof(PRESETS[0]) ? PRESETS[preset_index] : "";
+  apply_state_(mode, preset, level, target_temp);
+}
+
+uint8_t AutotermClimate::preset_index() const {
+  for (uint8_t i = 0; i < sizeof(PRESETS) / sizeof(PRESETS[0]); i++) {
+    if (preset_mode_ == PRESETS[i])
+      return i;
+  }
+  return NO_PRESET;
+}
+
+void AutotermClimate::handle_settings_update(const AutotermUART::Settings &settings) {
+  // Im Thermostatbetrieb schaltet der ESP selbst, die Settings zeigen nur den letzten Schaltbefehl
+  if (preset_mode_ == "Thermostat" && parent_ != nullptr && parent_->thermostat_.active())
     return;
 
+  climate::ClimateMode mode = this->mode;
+  std::string preset = preset_mode_;
+  switch (autoterm::settings_mode(settings)) {
+    case autoterm::SettingsMode::STANDBY:
+      mode = climate::CLIMATE_MODE_OFF;
+      break;
+    case autoterm::SettingsMode::POWER:
+      mode = climate::CLIMATE_MODE_HEAT;
+      preset = "Leistungsmodus";
+      break;
+    case autoterm::SettingsMode::HEAT:
+      mode = climate::CLIMATE_MODE_HEAT;
+      preset = "Heizen";
+      break;
+    case autoterm::SettingsMode::HEAT_FAN:
+      mode = climate::CLIMATE_MODE_AUTO;
+      preset = "Heizen+Lüften";
+      break;
+    case autoterm::SettingsMode::UNKNOWN:
+      break;
+  }
   uint8_t level = clamp_level_(settings.power_level);
   float target = clamp_temperature_(static_cast<float>(settings.set_temperature));
-  std::string preset = deduce_preset_from_settings_(settings);
-  climate::ClimateMode mode = deduce_mode_from_settings_(settings);
 
   apply_state_(mode, preset, level, target);
 }
@@ -1496,28 +2319,6 @@ uint8_t AutotermClimate::resolve_temp_sensor_() const {
   return sensor;
 }
 
-climate::ClimateMode AutotermClimate::deduce_mode_from_settings_(const AutotermUART::Settings &settings) const {
-  if (settings.wait_mode == 0x00 && settings.power_level == 0)
-    return climate::CLIMATE_MODE_OFF;
-  if (settings.temperature_source == 0x04)
-    return climate::CLIMATE_MODE_HEAT;
-  if (settings.wait_mode == 0x01)
-    return climate::CLIMATE_MODE_AUTO;
-  if (settings.wait_mode == 0x02)
-    return climate::CLIMATE_MODE_HEAT;
-  return this->mode;
-}
-
-std::string AutotermClimate::deduce_preset_from_settings_(const AutotermUART::Settings &settings) const {
-  if (settings.temperature_source == 0x04)
-    return "Leistungsmodus";
-  if (settings.wait_mode == 0x01)
-    return "Heizen+Lüften";
-  if (settings.wait_mode == 0x02)
-    return "Heizen";
-  return preset_mode_;
-}
-
 std::string AutotermClimate::preset_from_enum_(climate::ClimatePreset preset) {
   switch (preset) {
     case climate::CLIMATE_PRESET_NONE:    return "Leistungsmodus";
@@ -1586,6 +2387,8 @@ void AutotermClimate::apply_state_(climate::ClimateMode mode, const std::string
     this->action = climate::CLIMATE_ACTION_HEATING;
 
   this->publish_state();
+  if (parent_ != nullptr)
+    parent_->request_state_save();
 }
 
 void AutotermClimate::update_action_from_status_(uint16_t status_code) {
@@ -1629,9 +2432,10 @@ void AutotermUART::set_climate(AutotermClimate *climate) {
   if (climate_ != nullptr) {
     climate_->set_parent(this);
     if (settings_valid_)
-      climate_->handle_settings_update(settings_, false);
+      climate_->handle_settings_update(settings_);
   }
 }
+#endif
 
 }  // namespace autoterm_uart
 }  // namespace esphome
@@ -0,0 +1,702 @@
+// ======================
+// Autoterm Heizungs-Emulator
+// ======================
+// Spielt die Heizung (Gerät 0x04) auf einer seriellen Schnittstelle, z. B. am
+// heater-peer-Ende von tools/host/autoterm_ptys.sh oder an einem USB-UART vor
+// dem ESP32. Beantwortet 0x0F mit Statusframes, 0x02 mit Settings, spiegelt 0x11
+// und nimmt 0x01/0x02/0x03/0x23 an. Start und Stopp laufen durch die
+// Statuscodes, die parse_status() kennt.
+//
+// Optional übernimmt das Tool auch das Bedienteil (--display): es schickt dann
+// zyklisch Anfragen durch die Bridge und misst Antwortzeiten und Steuerlatenz.
+//
+// Bauen und Starten (aus dem Repository-Root):
+//   g++ -std=c++17 -O2 -I components/autoterm_uart -o autoterm_heater_emu
+//       tools/autoterm_heater_emu.cpp components/autoterm_uart/autoterm_protocol.cpp
+//   ./autoterm_heater_emu [--heater PATH] [--display PATH] [--latency-ms N] [--jitter-ms N]
+//       [--noise P] [--display-interval-ms N] [--toggle-s N] [--speed N] [--duration-s N] [--seed N]
+#include "autoterm_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+static constexpr uint32_t BAUD_RATE = 9600;
+// 8N1: 10 Bitzeiten pro Byte
+static constexpr uint32_t BYTE_TIME_US = (10 * 1000000UL) / BAUD_RATE;
+// Statusframe der Heizung: AA 04 13 00 0F + 19 Byte Nutzdaten + CRC = 26 Byte
+static constexpr size_t STATUS_PAYLOAD = 19;
+static constexpr size_t REPLY_SLOTS = 8;
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void on_signal(int) { g_stop = 1; }
+
+uint64_t now_us() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// ===================
+// Serielle Schnittstelle (tty/pty, raw, 9600 8N1)
+// ===================
+class SerialPort {
+ public:
+  ~SerialPort() {
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  bool open(const char *path) {
+    fd_ = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0)
+      return false;
+    termios tio;
+    if (::tcgetattr(fd_, &tio) == 0) {
+      ::cfmakeraw(&tio);
+      ::cfsetispeed(&tio, B9600);
+      ::cfsetospeed(&tio, B9600);
+      tio.c_cflag |= CLOCAL | CREAD;
+      ::tcsetattr(fd_, TCSANOW, &tio);
+    }
+    ::tcflush(fd_, TCIOFLUSH);
+    return true;
+  }
+
+  size_t read(uint8_t *data, size_t length) {
+    ssize_t n = ::read(fd_, data, length);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+  void write(const uint8_t *data, size_t length) {
+    while (length > 0) {
+      ssize_t n = ::write(fd_, data, length);
+      if (n <= 0)
+        return;
+      data += n;
+      length -= static_cast<size_t>(n);
+    }
+  }
+  int fd() const { return fd_; }
+
+ protected:
+  int fd_{-1};
+};
+
+// Ergänzt Header und CRC, liefert die Gesamtlänge
+size_t build_frame(uint8_t device, uint8_t command, const uint8_t *payload, size_t payload_length, uint8_t *out) {
+  out[0] = autoterm::FRAME_START;
+  out[1] = device;
+  out[2] = static_cast<uint8_t>(payload_length);
+  out[3] = 0x00;
+  out[4] = command;
+  if (payload_length > 0)
+    std::memcpy(out + autoterm::FRAME_HEADER_LENGTH, payload, payload_length);
+  size_t body = autoterm::FRAME_HEADER_LENGTH + payload_length;
+  uint16_t crc = autoterm::crc16_modbus(out, body);
+  out[body] = static_cast<uint8_t>(crc >> 8);
+  out[body + 1] = static_cast<uint8_t>(crc & 0xFF);
+  return body + autoterm::FRAME_CRC_LENGTH;
+}
+
+// Schiebt ein Byte in den Assembler und ruft on_frame(frame, length, crc_valid)
+// für jeden fertigen Frame; verworfene Kandidaten werden übersprungen
+template<typename Handler> void assemble(autoterm::BridgeFrameAssembler &assembler, uint8_t b, Handler on_frame) {
+  autoterm::BridgeFrameAssembler::Result result = assembler.push(b);
+  for (;;) {
+    if (result == autoterm::BridgeFrameAssembler::Result::RESYNC) {
+      assembler.discard(assembler.skip_length());
+    } else if (result == autoterm::BridgeFrameAssembler::Result::FRAME) {
+      size_t total = assembler.frame_length();
+      uint8_t frame[autoterm::BridgeFrameAssembler::MAX_ASSEMBLED_FRAME];
+      assembler.copy_to(frame, total);
+      bool crc_valid = assembler.frame_crc_valid();
+      assembler.discard(total);
+      on_frame(frame, total, crc_valid);
+      if (assembler.empty())
+        return;
+    } else {
+      return;
+    }
+    result = assembler.resume();
+  }
+}
+
+// ===================
+// Heizungsmodell
+// ===================
+// Start: 0x0200 → 0x0201 → 0x0202 → 0x0203 → 0x0204 → 0x0300
+// Stopp: 0x0304 → 0x0305 → 0x0001, Nur-Lüfter 0x0323 → 0x0305 → 0x0001
+struct Phase {
+  uint16_t code;
+  uint32_t duration_ms;
+  uint16_t next;
+};
+
+static constexpr Phase PHASES[] = {
+    {0x0200, 2000, 0x0201}, {0x0201, 8000, 0x0202}, {0x0202, 4000, 0x0203}, {0x0203, 4000, 0x0204},
+    {0x0204, 10000, 0x0300}, {0x0304, 12000, 0x0305}, {0x0305, 6000, 0x0001},
+};
+
+const Phase *find_phase(uint16_t code) {
+  for (const auto &phase : PHASES) {
+    if (phase.code == code)
+      return &phase;
+  }
+  return nullptr;
+}
+
+class HeaterModel {
+ public:
+  explicit HeaterModel(uint32_t speed) : speed_(std::max<uint32_t>(speed, 1)) {
+    settings_.use_work_time = 0;
+    settings_.work_time = 0x78;
+    settings_.temperature_source = 2;
+    settings_.set_temperature = 15;
+    settings_.wait_mode = 1;
+    settings_.power_level = 0;
+  }
+
+  // Nutzdaten von 0x01/0x02, 0xFF heißt "unverändert"
+  void apply_settings(const uint8_t *p, size_t length) {
+    uint8_t *fields[] = {&settings_.use_work_time,   &settings_.work_time, &settings_.temperature_source,
+                         &settings_.set_temperature, &settings_.wait_mode, &settings_.power_level};
+    for (size_t i = 0; i < std::min<size_t>(length, autoterm::SettingsFrame::PAYLOAD); i++) {
+      if (p[i] != 0xFF)
+        *fields[i] = p[i];
+    }
+  }
+
+  void start(uint64_t now_ms) {
+    if (code_ == 0x0001 || code_ == 0x0304 || code_ == 0x0305 || code_ == 0x0323)
+      enter_(0x0200, now_ms);
+  }
+  void stop(uint64_t now_ms) {
+    if (code_ == 0x0323)
+      enter_(0x0305, now_ms);
+    else if (code_ >= 0x0200 && code_ <= 0x0300)
+      enter_(0x0304, now_ms);
+  }
+  void fan_only(uint8_t level, uint64_t now_ms) {
+    if (level != 0xFF)
+      fan_level_ = std::min<uint8_t>(level, 9);
+    if (code_ == 0x0001 || code_ == 0x0305)
+      enter_(0x0323, now_ms);
+  }
+
+  void step(uint64_t now_ms) {
+    const Phase *phase = find_phase(code_);
+    if (phase != nullptr && now_ms - entered_ms_ >= phase->duration_ms / speed_)
+      enter_(phase->next, now_ms);
+
+    // Wärmetauscher folgt dem Brennerzustand mit Verzögerung erster Ordnung
+    if (now_ms - last_thermal_ms_ >= 200) {
+      last_thermal_ms_ = now_ms;
+      float target = AMBIENT_C;
+      if (code_ == 0x0300)
+        target = 80.0f + settings_.power_level * 4.0f;
+      else if (code_ >= 0x0202 && code_ <= 0x0204)
+        target = 60.0f;
+      heater_temp_c_ += (target - heater_temp_c_) * 0.02f * static_cast<float>(speed_);
+      if (fan_actual_ < fan_set_())
+        fan_actual_++;
+      else if (fan_actual_ > fan_set_())
+        fan_actual_--;
+    }
+  }
+
+  void status_payload(uint8_t *p) const {
+    std::memset(p, 0, STATUS_PAYLOAD);
+    p[0] = static_cast<uint8_t>(code_ >> 8);
+    p[1] = static_cast<uint8_t>(code_ & 0xFF);
+    p[3] = static_cast<uint8_t>(AMBIENT_C + 4.0f);  // Innensensor
+    p[4] = 0x7F;                                    // kein Außensensor
+    p[6] = code_ == 0x0001 ? 132 : 131;             // 13,2 V bzw. 13,1 V unter Last
+    uint16_t raw = static_cast<uint16_t>(0x100 + static_cast<int>(heater_temp_c_ * 2.0f));
+    p[7] = static_cast<uint8_t>(raw >> 8);
+    p[8] = static_cast<uint8_t>(raw & 0xFF);
+    p[9] = code_ == 0x0001 ? 0x00 : 0x04;
+    p[11] = fan_set_();
+    p[12] = fan_actual_;
+    p[14] = pump_();
+    p[16] = pump_();
+    p[18] = 0x66;
+  }
+
+  void settings_payload(uint8_t *p) const {
+    p[0] = settings_.use_work_time;
+    p[1] = settings_.work_time;
+    p[2] = settings_.temperature_source;
+    p[3] = settings_.set_temperature;
+    p[4] = settings_.wait_mode;
+    p[5] = settings_.power_level;
+  }
+
+  uint16_t code() const { return code_; }
+  uint32_t transitions() const { return transitions_; }
+
+ protected:
+  static constexpr float AMBIENT_C = 18.0f;
+
+  void enter_(uint16_t code, uint64_t now_ms) {
+    if (code == code_)
+      return;
+    const char *text = autoterm::status_text(code);
+    std::printf("  status 0x%04X %s\n", code, text != nullptr ? text : "");
+    code_ = code;
+    entered_ms_ = now_ms;
+    transitions_++;
+  }
+  // Lüfter-Soll in 60-rpm-Schritten (0x28 = 2400 rpm bei Stufe 0 im Log)
+  uint8_t fan_set_() const {
+    switch (code_) {
+      case 0x0001: return 0;
+      case 0x0200:
+      case 0x0201: return 10;
+      case 0x0323: return static_cast<uint8_t>(20 + fan_level_ * 6);
+      case 0x0304:
+      case 0x0305: return 50;
+      default: return static_cast<uint8_t>(40 + settings_.power_level * 6);
+    }
+  }
+  // Pumpenfrequenz in 1/100 Hz (0x46 = 0,70 Hz bei Stufe 0 im Log)
+  uint8_t pump_() const {
+    if (code_ == 0x0300)
+      return static_cast<uint8_t>(70 + settings_.power_level * 40);
+    if (code_ >= 0x0202 && code_ <= 0x0204)
+      return 50;
+    return 0;
+  }
+
+  uint32_t speed_;
+  autoterm::Settings settings_;
+  uint16_t code_{0x0001};
+  uint64_t entered_ms_{0};
+  uint64_t last_thermal_ms_{0};
+  float heater_temp_c_{AMBIENT_C};
+  uint8_t fan_actual_{0};
+  uint8_t fan_level_{5};
+  uint32_t transitions_{0};
+};
+
+// ===================
+// Emulator-Optionen und Statistik
+// ===================
+struct Options {
+  const char *heater_path{"/tmp/autoterm/heater-peer"};
+  const char *display_path{nullptr};
+  uint32_t latency_us{20000};
+  uint32_t jitter_us{0};
+  double noise{0.0};
+  uint32_t display_interval_us{250000};
+  uint32_t toggle_us{0};
+  uint32_t speed{1};
+  uint32_t duration_us{0};
+  uint32_t seed{1};
+};
+
+struct HeaterStats {
+  uint32_t frames{0};
+  uint32_t crc_errors{0};
+  uint32_t answered{0};
+  uint32_t commands{0};
+  uint32_t unknown{0};
+  uint32_t collision_bytes{0};
+  uint32_t collided_frames{0};
+  uint32_t corrupted_replies{0};
+  uint32_t garbage_bursts{0};
+};
+
+struct PendingReply {
+  uint64_t due_us;
+  uint8_t bytes[autoterm::FRAME_OVERHEAD + STATUS_PAYLOAD];
+  uint8_t length;
+};
+
+// ===================
+// Heizungs-Seite
+// ===================
+class HeaterEndpoint {
+ public:
+  HeaterEndpoint(SerialPort &port, const Options &options, std::mt19937 &rng)
+      : port_(port), options_(options), rng_(rng), model_(options.speed) {}
+
+  void poll(uint64_t now) {
+    uint8_t chunk[64];
+    size_t length;
+    while ((length = port_.read(chunk, sizeof(chunk))) > 0) {
+      for (size_t i = 0; i < length; i++)
+        push_(chunk[i], now);
+    }
+    model_.step(now / 1000);
+    send_due_(now);
+  }
+
+  const HeaterStats &stats() const { return stats_; }
+  const autoterm::FrameAssemblerStats &assembler_stats() const { return assembler_.stats(); }
+  const HeaterModel &model() const { return model_; }
+
+ protected:
+  void push_(uint8_t b, uint64_t now) {
+    // Halbduplex: Bytes, die während einer eigenen Antwort ankommen, wären auf
+    // dem echten Bus kollidiert
+    if (now < tx_busy_until_us_) {
+      stats_.collision_bytes++;
+      collided_ = true;
+    }
+    assemble(assembler_, b, [&](const uint8_t *frame, size_t length, bool crc_valid) {
+      stats_.frames++;
+      if (collided_)
+        stats_.collided_frames++;
+      collided_ = false;
+      if (!crc_valid) {
+        stats_.crc_errors++;
+        return;
+      }
+      handle_frame_(autoterm::FrameView(frame, length), now);
+    });
+  }
+
+  void handle_frame_(const autoterm::FrameView &frame, uint64_t now) {
+    if (!frame.valid() || frame.device() != autoterm::DEVICE_CONTROLLER)
+      return;
+    uint64_t now_ms = now / 1000;
+    uint8_t payload[STATUS_PAYLOAD];
+    size_t payload_length = 0;
+    switch (frame.command()) {
+      case autoterm::CMD_STATUS:
+        model_.status_payload(payload);
+        payload_length = STATUS_PAYLOAD;
+        break;
+      case autoterm::CMD_SETTINGS:
+        if (frame.payload_length() > 0) {
+          model_.apply_settings(frame.payload(), frame.payload_length());
+          stats_.commands++;
+        }
+        model_.settings_payload(payload);
+        payload_length = autoterm::SettingsFrame::PAYLOAD;
+        break;
+      case autoterm::CMD_START:
+        model_.apply_settings(frame.payload(), frame.payload_length());
+        model_.start(now_ms);
+        stats_.commands++;
+        payload_length = std::min(frame.payload_length(), sizeof(payload));
+        std::memcpy(payload, frame.payload(), payload_length);
+        break;
+      case autoterm::CMD_STANDBY:
+        model_.stop(now_ms);
+        stats_.commands++;
+        break;
+      case autoterm::CMD_FAN_ONLY:
+        model_.fan_only(frame.payload_length() >= 3 ? frame.payload()[2] : 0xFF, now_ms);
+        stats_.commands++;
+        payload_length = std::min(frame.payload_length(), sizeof(payload));
+        std::memcpy(payload, frame.payload(), payload_length);
+        break;
+      case autoterm::CMD_PANEL_TEMPERATURE:
+        payload_length = std::min(frame.payload_length(), sizeof(payload));
+        std::memcpy(payload, frame.payload(), payload_length);
+        break;
+      default:
+        stats_.unknown++;
+        return;
+    }
+    queue_reply_(frame.command(), payload, payload_length, now);
+  }
+
+  void queue_reply_(uint8_t command, const uint8_t *payload, size_t payload_length, uint64_t now) {
+    if (reply_count_ == REPLY_SLOTS)
+      return;
+    PendingReply &reply = replies_[reply_count_++];
+    uint32_t jitter = options_.jitter_us > 0 ? rng_() % (options_.jitter_us + 1) : 0;
+    reply.due_us = now + options_.latency_us + jitter;
+    reply.length = static_cast<uint8_t>(build_frame(autoterm::DEVICE_HEATER, command, payload, payload_length, reply.bytes));
+    stats_.answered++;
+  }
+
+  void send_due_(uint64_t now) {
+    while (reply_count_ > 0 && replies_[0].due_us <= now && now >= tx_busy_until_us_) {
+      PendingReply &reply = replies_[0];
+      size_t wire_bytes = reply.length;
+      if (options_.noise > 0.0 && unit_(rng_) < options_.noise) {
+        if (rng_() & 1) {
+          // Ein gekipptes Byte: die Bridge sieht einen CRC-Fehler
+          reply.bytes[1 + rng_() % (reply.length - 1)] ^= static_cast<uint8_t>(1u << (rng_() % 8));
+          stats_.corrupted_replies++;
+        } else {
+          // Störbytes vor dem Frame: die Bridge muss neu synchronisieren
+          uint8_t garbage[4];
+          size_t count = 1 + rng_() % sizeof(garbage);
+          for (size_t i = 0; i < count; i++) {
+            garbage[i] = static_cast<uint8_t>(rng_());
+            if (garbage[i] == autoterm::FRAME_START)
+              garbage[i] = 0x55;
+          }
+          port_.write(garbage, count);
+          wire_bytes += count;
+          stats_.garbage_bursts++;
+        }
+      }
+      port_.write(reply.bytes, reply.length);
+      tx_busy_until_us_ = now + wire_bytes * BYTE_TIME_US;
+      std::copy(replies_ + 1, replies_ + reply_count_, replies_);
+      reply_count_--;
+    }
+  }
+
+  SerialPort &port_;
+  const Options &options_;
+  std::mt19937 &rng_;
+  std::uniform_real_distribution<double> unit_{0.0, 1.0};
+  HeaterModel model_;
+  autoterm::BridgeFrameAssembler assembler_;
+  HeaterStats stats_;
+  PendingReply replies_[REPLY_SLOTS];
+  size_t reply_count_{0};
+  uint64_t tx_busy_until_us_{0};
+  bool collided_{false};
+};
+
+// ===================
+// Bedienteil-Seite ("chatty display")
+// ===================
+// Zyklus wie beim echten Bedienteil: Status, Panel-Temperatur, Status, Settings.
+// Mit --toggle-s wird abwechselnd gestartet und gestoppt; gemessen wird, bis der
+// Status über die Bridge zurückkommt.
+class DisplayEndpoint {
+ public:
+  DisplayEndpoint(SerialPort &port, const Options &options) : port_(port), options_(options) {}
+
+  void poll(uint64_t now) {
+    uint8_t chunk[64];
+    size_t length;
+    while ((length = port_.read(chunk, sizeof(chunk))) > 0) {
+      for (size_t i = 0; i < length; i++)
+        push_(chunk[i], now);
+    }
+    if (options_.toggle_us > 0 && now - last_toggle_us_ >= options_.toggle_us) {
+      last_toggle_us_ = now;
+      send_toggle_(now);
+    } else if (now - last_request_us_ >= options_.display_interval_us) {
+      last_request_us_ = now;
+      send_request_(now);
+    }
+  }
+
+  void print() const {
+    std::printf("display: sent=%u replies=%u crc_errors=%u timeouts=%u\n", static_cast<unsigned>(sent_),
+                static_cast<unsigned>(replies_), static_cast<unsigned>(crc_errors_), static_cast<unsigned>(timeouts_));
+    std::printf("  round trip   avg=%4ums p50=%4ums p95=%4ums max=%4ums\n", static_cast<unsigned>(round_trip_ms_.average()),
+                static_cast<unsigned>(round_trip_ms_.percentile(50)),
+                static_cast<unsigned>(round_trip_ms_.percentile(95)), static_cast<unsigned>(round_trip_ms_.max()));
+    if (control_ms_.count() > 0)
+      std::printf("  control      avg=%4ums p95=%4ums max=%4ums (%u toggles)\n",
+                  static_cast<unsigned>(control_ms_.average()), static_cast<unsigned>(control_ms_.percentile(95)),
+                  static_cast<unsigned>(control_ms_.max()), static_cast<unsigned>(control_ms_.count()));
+  }
+
+ protected:
+  static constexpr uint32_t REPLY_TIMEOUT_US = 1000000;
+
+  void push_(uint8_t b, uint64_t now) {
+    assemble(assembler_, b, [&](const uint8_t *frame, size_t length, bool crc_valid) {
+      if (!crc_valid) {
+        crc_errors_++;
+        return;
+      }
+      handle_frame_(autoterm::FrameView(frame, length), now);
+    });
+  }
+
+  void handle_frame_(const autoterm::FrameView &frame, uint64_t now) {
+    if (!frame.valid() || !frame.from_heater())
+      return;
+    if (waiting_ && frame.command() == waiting_command_) {
+      round_trip_ms_.add(static_cast<uint32_t>((now - waiting_since_us_) / 1000));
+      replies_++;
+      waiting_ = false;
+    }
+    if (!autoterm::StatusFrame::matches(frame) || control_since_us_ == 0)
+      return;
+    uint16_t code = autoterm::StatusFrame(frame).code();
+    bool reached = want_active_ ? code != 0x0001 : (code == 0x0304 || code == 0x0305 || code == 0x0001);
+    if (reached) {
+      control_ms_.add(static_cast<uint32_t>((now - control_since_us_) / 1000));
+      control_since_us_ = 0;
+    }
+  }
+
+  void send_request_(uint64_t now) {
+    if (waiting_ && now - waiting_since_us_ >= REPLY_TIMEOUT_US) {
+      timeouts_++;
+      waiting_ = false;
+    }
+    if (waiting_)
+      return;
+    switch (cycle_++ % 4) {
+      case 0:
+      case 2: send_(autoterm::STATUS_REQUEST_FRAME.data(), autoterm::STATUS_REQUEST_FRAME.size(), now); break;
+      case 1: {
+        auto frame = autoterm::panel_temperature_frame(0x13);
+        send_(frame.data(), frame.size(), now);
+        break;
+      }
+      default:
+        send_(autoterm::SETTINGS_REQUEST_FRAME.data(), autoterm::SETTINGS_REQUEST_FRAME.size(), now);
+        break;
+    }
+  }
+
+  void send_toggle_(uint64_t now) {
+    want_active_ = !want_active_;
+    control_since_us_ = now;
+    if (want_active_) {
+      auto frame = autoterm::power_mode_frame(true, 2);
+      send_(frame.data(), frame.size(), now);
+    } else {
+      send_(autoterm::STANDBY_FRAME.data(), autoterm::STANDBY_FRAME.size(), now);
+    }
+  }
+
+  void send_(const uint8_t *frame, size_t length, uint64_t now) {
+    port_.write(frame, length);
+    sent_++;
+    waiting_ = true;
+    waiting_command_ = frame[4];
+    waiting_since_us_ = now;
+  }
+
+  SerialPort &port_;
+  const Options &options_;
+  autoterm::BridgeFrameAssembler assembler_;
+  autoterm::Histogram<64, 10> round_trip_ms_;
+  autoterm::Histogram<64, 100> control_ms_;
+  uint64_t last_request_us_{0};
+  uint64_t last_toggle_us_{0};
+  uint64_t waiting_since_us_{0};
+  uint64_t control_since_us_{0};
+  uint32_t cycle_{0};
+  uint32_t sent_{0};
+  uint32_t replies_{0};
+  uint32_t crc_errors_{0};
+  uint32_t timeouts_{0};
+  uint8_t waiting_command_{0};
+  bool waiting_{false};
+  bool want_active_{false};
+};
+
+bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char *value = argv[++i];
+    uint32_t number = static_cast<uint32_t>(std::max(0, std::atoi(value)));
+    if (std::strcmp(arg, "--heater") == 0) {
+      options.heater_path = value;
+    } else if (std::strcmp(arg, "--display") == 0) {
+      options.display_path = value;
+    } else if (std::strcmp(arg, "--latency-ms") == 0) {
+      options.latency_us = number * 1000;
+    } else if (std::strcmp(arg, "--jitter-ms") == 0) {
+      options.jitter_us = number * 1000;
+    } else if (std::strcmp(arg, "--noise") == 0) {
+      options.noise = std::min(1.0, std::max(0.0, std::atof(value)));
+    } else if (std::strcmp(arg, "--display-interval-ms") == 0) {
+      options.display_interval_us = std::max<uint32_t>(number, 1) * 1000;
+    } else if (std::strcmp(arg, "--toggle-s") == 0) {
+      options.toggle_us = number * 1000000;
+    } else if (std::strcmp(arg, "--speed") == 0) {
+      options.speed = std::max<uint32_t>(number, 1);
+    } else if (std::strcmp(arg, "--duration-s") == 0) {
+      options.duration_us = number * 1000000;
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options.seed = number;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--heater PATH] [--display PATH] [--latency-ms N] [--jitter-ms N] [--noise P]\n"
+                 "          [--display-interval-ms N] [--toggle-s N] [--speed N] [--duration-s N] [--seed N]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  SerialPort heater_port;
+  if (!heater_port.open(options.heater_path)) {
+    std::fprintf(stderr, "%s: cannot open\n", options.heater_path);
+    return 1;
+  }
+  SerialPort display_port;
+  if (options.display_path != nullptr && !display_port.open(options.display_path)) {
+    std::fprintf(stderr, "%s: cannot open\n", options.display_path);
+    return 1;
+  }
+
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  std::mt19937 rng(options.seed);
+  HeaterEndpoint heater(heater_port, options, rng);
+  DisplayEndpoint display(display_port, options);
+  bool chatty = options.display_path != nullptr;
+
+  std::printf("heater on %s, latency %ums + 0..%ums jitter, noise %.3f\n", options.heater_path,
+              static_cast<unsigned>(options.latency_us / 1000), static_cast<unsigned>(options.jitter_us / 1000),
+              options.noise);
+  if (chatty)
+    std::printf("display on %s, every %ums\n", options.display_path,
+                static_cast<unsigned>(options.display_interval_us / 1000));
+
+  uint64_t start = now_us();
+  while (!g_stop) {
+    pollfd fds[2] = {{heater_port.fd(), POLLIN, 0}, {display_port.fd(), POLLIN, 0}};
+    ::poll(fds, chatty ? 2 : 1, 1);
+    uint64_t now = now_us() - start;
+    heater.poll(now);
+    if (chatty)
+      display.poll(now);
+    if (options.duration_us > 0 && now >= options.duration_us)
+      break;
+  }
+
+  double seconds = (now_us() - start) / 1e6;
+  const HeaterStats &stats = heater.stats();
+  const autoterm::FrameAssemblerStats &framing = heater.assembler_stats();
+  std::printf("\nheater: %.1f s, %u frames (%.1f frames/s), %u answered, %u commands, %u unknown\n", seconds,
+              static_cast<unsigned>(stats.frames), seconds > 0 ? stats.frames / seconds : 0.0,
+              static_cast<unsigned>(stats.answered), static_cast<unsigned>(stats.commands),
+              static_cast<unsigned>(stats.unknown));
+  std::printf("  crc_errors=%u passthrough_bytes=%u resyncs=%u false_starts=%u\n",
+              static_cast<unsigned>(stats.crc_errors), static_cast<unsigned>(framing.passthrough_bytes.get()),
+              static_cast<unsigned>(framing.resyncs.get()), static_cast<unsigned>(framing.false_starts.get()));
+  std::printf("  collisions: %u bytes in %u frames\n", static_cast<unsigned>(stats.collision_bytes),
+              static_cast<unsigned>(stats.collided_frames));
+  std::printf("  noise: %u corrupted replies, %u garbage bursts\n", static_cast<unsigned>(stats.corrupted_replies),
+              static_cast<unsigned>(stats.garbage_bursts));
+  std::printf("  status transitions=%u, final 0x%04X\n", static_cast<unsigned>(heater.model().transitions()),
+              heater.model().code());
+  if (chatty)
+    display.print();
+  return 0;
+}
@@ -0,0 +1,683 @@
+// ===================
+// Autoterm Log-Replay
+// ===================
+// Liest Frame-Dumps aus ESPHome-Logs ([display→heater] / [heater→display]),
+// baut daraus die beiden Bytestrome mit ihrem ursprünglichen Timing nach und
+// schickt sie durch die Bridge-Kanäle des Protokoll-Kerns.
+//
+// Bauen und Starten (aus dem Repository-Root):
+//   g++ -std=c++17 -O2 -I components/autoterm_uart -o autoterm_replay
+//       tools/autoterm_replay.cpp components/autoterm_uart/autoterm_protocol.cpp
+//   ./autoterm_replay logs_air2d_run_Thermostat.txt [--cut-through] [--iterations N] [--poll-ms N]
+//       [--noise P] [--seed N]
+//   ./autoterm_replay --checks
+//
+// Zusätzlich läuft derselbe Strom über eine simulierte UART, die wie der
+// Adapter blockweise mit read_array() im Loop-Takt (--poll-ms) geleert wird.
+// Ausgabe und dekodierte Frames müssen dem byteweisen Pfad entsprechen.
+//
+// Mit --noise wird jeder Frame mit Wahrscheinlichkeit P gestört (Störbytes mit
+// 0xAA davor, abgeschnitten oder ein gekipptes Bit). Gemessen wird, wie viele
+// unversehrte Frames verloren gehen und wie spät der erste danach erkannt wird.
+#include "autoterm_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ===================
+// Allokationszähler
+// ===================
+static size_t g_allocations = 0;
+
+void *operator new(size_t size) {
+  g_allocations++;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+static constexpr uint32_t BAUD_RATE = 9600;
+// 8N1: 10 Bitzeiten pro Byte
+static constexpr uint32_t BYTE_TIME_US = (10 * 1000000UL) / BAUD_RATE;
+
+struct CapturedFrame {
+  uint64_t time_us;  // Zeitpunkt des letzten Bytes laut Log
+  bool from_display;
+  std::vector<uint8_t> bytes;
+};
+
+struct ReplayByte {
+  uint32_t time_us;
+  bool from_display;
+  uint8_t value;
+};
+
+// "[17:22:10.864][D][autoterm_uart:311]: [display→heater] Frame (8 bytes): AA 03 ..."
+// Neuere Logs werden verzögert formatiert: "Frame (8 bytes, 12ms ago): AA 03 ..."
+bool parse_log_line(const std::string &line, CapturedFrame &out) {
+  unsigned h, m, s, ms;
+  if (std::sscanf(line.c_str(), "[%u:%u:%u.%u]", &h, &m, &s, &ms) != 4)
+    return false;
+
+  size_t dir_pos;
+  if ((dir_pos = line.find("[display→heater] Frame")) != std::string::npos) {
+    out.from_display = true;
+  } else if ((dir_pos = line.find("[heater→display] Frame")) != std::string::npos) {
+    out.from_display = false;
+  } else {
+    return false;
+  }
+
+  size_t hex_pos = line.find("): ", dir_pos);
+  if (hex_pos == std::string::npos)
+    return false;
+
+  out.time_us = ((static_cast<uint64_t>(h) * 3600 + m * 60 + s) * 1000 + ms) * 1000;
+  size_t age_pos = line.find("ms ago)", dir_pos);
+  if (age_pos != std::string::npos && age_pos < hex_pos + 1) {
+    size_t comma = line.rfind(", ", age_pos);
+    uint64_t age_ms = std::strtoull(line.c_str() + comma + 2, nullptr, 10);
+    out.time_us = out.time_us > age_ms * 1000 ? out.time_us - age_ms * 1000 : 0;
+  }
+  out.bytes.clear();
+  const char *p = line.c_str() + hex_pos + 3;
+  while (*p != '\0') {
+    char *end;
+    unsigned long value = std::strtoul(p, &end, 16);
+    if (end == p)
+      break;
+    out.bytes.push_back(static_cast<uint8_t>(value));
+    p = end;
+  }
+  return !out.bytes.empty();
+}
+
+bool load_capture(const char *path, std::vector<CapturedFrame> &frames) {
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  CapturedFrame frame;
+  while (std::getline(in, line)) {
+    if (parse_log_line(line, frame))
+      frames.push_back(frame);
+  }
+  return true;
+}
+
+// Legt die Bytes jedes Frames rückwärts vom Log-Zeitstempel mit Baudraten-Abstand ab.
+// Frames derselben Richtung dürfen sich dabei nicht überlappen.
+std::vector<ReplayByte> build_stream(const std::vector<CapturedFrame> &frames,
+                                     std::vector<uint32_t> *frame_start_us = nullptr) {
+  std::vector<ReplayByte> stream;
+  if (frames.empty())
+    return stream;
+  uint64_t origin = frames.front().time_us;
+  uint64_t line_free[2] = {origin, origin};
+  for (const auto &frame : frames) {
+    uint64_t duration = static_cast<uint64_t>(frame.bytes.size()) * BYTE_TIME_US;
+    uint64_t &free_at = line_free[frame.from_display ? 0 : 1];
+    uint64_t start = frame.time_us > origin + duration ? frame.time_us - duration : origin;
+    start = std::max(start, free_at);
+    free_at = start + duration;
+    if (frame_start_us != nullptr)
+      frame_start_us->push_back(static_cast<uint32_t>(start - origin));
+    for (size_t i = 0; i < frame.bytes.size(); i++)
+      stream.push_back({static_cast<uint32_t>(start - origin + i * BYTE_TIME_US), frame.from_display, frame.bytes[i]});
+  }
+  std::stable_sort(stream.begin(), stream.end(),
+                   [](const ReplayByte &a, const ReplayByte &b) { return a.time_us < b.time_us; });
+  return stream;
+}
+
+// Sammelt die weitergeleiteten Bytes in einem vorab reservierten Puffer
+class RecordingSink : public autoterm::ByteSink {
+ public:
+  void reserve(size_t size) { bytes_.reserve(size); }
+  void clear() { bytes_.clear(); }
+  void write(const uint8_t *data, size_t length) override { bytes_.insert(bytes_.end(), data, data + length); }
+  const std::vector<uint8_t> &bytes() const { return bytes_; }
+
+ protected:
+  std::vector<uint8_t> bytes_;
+};
+
+// Dekodiert wie der ESPHome-Adapter, aber ohne Entities
+class ReplayListener : public autoterm::BridgeChannelListener {
+ public:
+  bool may_rewrite_frame(const autoterm::BridgeChannel &, uint8_t, uint8_t) override { return false; }
+  bool rewrite_frame(const autoterm::BridgeChannel &, uint8_t *, size_t) override { return false; }
+  void on_frame(const autoterm::BridgeChannel &, const uint8_t *frame, size_t length, bool crc_valid) override {
+    frames++;
+    if (!crc_valid) {
+      crc_errors++;
+      return;
+    }
+    autoterm::Status status;
+    autoterm::Settings settings;
+    if (autoterm::decode_status(frame, length, status))
+      status_frames++;
+    else if (autoterm::decode_settings(frame, length, settings))
+      settings_frames++;
+  }
+
+  uint32_t frames{0};
+  uint32_t crc_errors{0};
+  uint32_t status_frames{0};
+  uint32_t settings_frames{0};
+};
+
+// Kopie der Latenzzähler eines Kanals, der am Ende des Laufs abgebaut wird
+struct LatencySummary {
+  uint32_t count{0};
+  uint32_t average_us{0};
+  uint32_t max_us{0};
+
+  static LatencySummary of(const autoterm::ForwardLatencyStats &stats) {
+    return {stats.count(), stats.average_us(), stats.max_us()};
+  }
+};
+
+struct ReplayResult {
+  ReplayListener listener;
+  LatencySummary latency[2];
+  bool byte_exact{true};
+  size_t allocations{0};
+  double cpu_ns{0.0};
+};
+
+void run_replay(const std::vector<ReplayByte> &stream, bool cut_through, ReplayResult &result,
+                RecordingSink sinks[2], std::vector<uint8_t> expected[2]) {
+  autoterm::BridgeChannel display_to_heater("display→heater", true);
+  autoterm::BridgeChannel heater_to_display("heater→display", false);
+  display_to_heater.set_cut_through(cut_through);
+  heater_to_display.set_cut_through(cut_through);
+  sinks[0].clear();
+  sinks[1].clear();
+
+  size_t allocations_before = g_allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &b : stream) {
+    // Wie forward_and_sniff(): Pausen vor dem nächsten Byte erkennen
+    display_to_heater.poll_gap(b.time_us, sinks[0]);
+    heater_to_display.poll_gap(b.time_us, sinks[1]);
+    if (b.from_display)
+      display_to_heater.push(b.value, b.time_us, sinks[0], result.listener);
+    else
+      heater_to_display.push(b.value, b.time_us, sinks[1], result.listener);
+  }
+  auto end = std::chrono::steady_clock::now();
+  result.allocations += g_allocations - allocations_before;
+  result.cpu_ns += std::chrono::duration<double, std::nano>(end - start).count();
+
+  result.latency[0] = LatencySummary::of(display_to_heater.latency());
+  result.latency[1] = LatencySummary::of(heater_to_display.latency());
+  for (int i = 0; i < 2; i++) {
+    if (sinks[i].bytes() != expected[i])
+      result.byte_exact = false;
+  }
+}
+
+// Simulierte UART: Bytes werden zu ihrem Zeitpunkt im RX-Puffer sichtbar
+class MockUart {
+ public:
+  MockUart(const std::vector<ReplayByte> &stream, bool from_display) : stream_(stream), from_display_(from_display) {}
+
+  void advance(uint32_t now_us) {
+    while (next_ < stream_.size() && stream_[next_].time_us <= now_us) {
+      if (stream_[next_].from_display == from_display_)
+        rx_[rx_count_++] = stream_[next_].value;
+      next_++;
+    }
+  }
+  int available() const { return static_cast<int>(rx_count_ - rx_read_); }
+  bool read_array(uint8_t *data, size_t length) {
+    if (length > rx_count_ - rx_read_)
+      return false;
+    std::memcpy(data, rx_ + rx_read_, length);
+    rx_read_ += length;
+    reads++;
+    if (rx_read_ == rx_count_)
+      rx_read_ = rx_count_ = 0;
+    return true;
+  }
+
+  uint32_t reads{0};
+
+ protected:
+  const std::vector<ReplayByte> &stream_;
+  bool from_display_;
+  size_t next_{0};
+  // Großzügig bemessen: der Simulator kennt keinen Überlauf
+  uint8_t rx_[4096];
+  size_t rx_read_{0};
+  size_t rx_count_{0};
+};
+
+struct BulkResult {
+  ReplayListener listener;
+  LatencySummary latency[2];
+  bool byte_exact{true};
+  uint32_t reads{0};
+  uint32_t polls{0};
+};
+
+// Entspricht forward_and_sniff() im Adapter: available() + read_array() in Blöcken
+void drain_bulk(MockUart &uart, autoterm::BridgeChannel &channel, uint32_t now_us, RecordingSink &sink,
+                ReplayListener &listener) {
+  uint8_t chunk[64];
+  int available;
+  while ((available = uart.available()) > 0) {
+    size_t length = std::min<size_t>(static_cast<size_t>(available), sizeof(chunk));
+    if (!uart.read_array(chunk, length))
+      break;
+    channel.push(chunk, length, now_us, sink, listener);
+  }
+  channel.poll_gap(now_us, sink);
+}
+
+void run_bulk_replay(const std::vector<ReplayByte> &stream, bool cut_through, uint32_t poll_us, BulkResult &result,
+                     RecordingSink sinks[2], std::vector<uint8_t> expected[2]) {
+  autoterm::BridgeChannel display_to_heater("display→heater", true);
+  autoterm::BridgeChannel heater_to_display("heater→display", false);
+  display_to_heater.set_cut_through(cut_through);
+  heater_to_display.set_cut_through(cut_through);
+  sinks[0].clear();
+  sinks[1].clear();
+
+  MockUart display(stream, true);
+  MockUart heater(stream, false);
+  uint32_t end_us = stream.empty() ? 0 : stream.back().time_us + poll_us;
+  for (uint32_t now = 0; now <= end_us; now += poll_us) {
+    display.advance(now);
+    heater.advance(now);
+    drain_bulk(display, display_to_heater, now, sinks[0], result.listener);
+    drain_bulk(heater, heater_to_display, now, sinks[1], result.listener);
+    result.polls++;
+  }
+  result.reads = display.reads + heater.reads;
+  result.latency[0] = LatencySummary::of(display_to_heater.latency());
+  result.latency[1] = LatencySummary::of(heater_to_display.latency());
+  for (int i = 0; i < 2; i++) {
+    if (sinks[i].bytes() != expected[i])
+      result.byte_exact = false;
+  }
+}
+
+// ===================
+// Störungen
+// ===================
+enum class Disturbance : uint8_t { NONE, JUNK, TRUNCATED, FLIPPED };
+
+struct NoisyFrame {
+  bool from_display;
+  Disturbance disturbance;
+  bool intact;            // Frame selbst unversehrt (auch JUNK: nur Störbytes davor)
+  uint32_t start_us;      // erstes Byte inkl. Störbytes
+  uint32_t last_byte_us;  // letztes Byte, frühester Zeitpunkt für die Erkennung
+};
+
+// Stört jeden Frame mit Wahrscheinlichkeit p und merkt sich, welche Frames unversehrt bleiben
+std::vector<CapturedFrame> inject_noise(const std::vector<CapturedFrame> &frames, double p, uint32_t seed,
+                                        std::vector<NoisyFrame> &info) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<CapturedFrame> noisy = frames;
+  info.clear();
+  for (auto &frame : noisy) {
+    NoisyFrame entry{frame.from_display, Disturbance::NONE, true, 0, 0};
+    if (unit(rng) < p && frame.bytes.size() > 1) {
+      entry.disturbance = static_cast<Disturbance>(1 + rng() % 3);
+      switch (entry.disturbance) {
+        case Disturbance::JUNK: {
+          // Streues 0xAA mit beliebigen Bytes dahinter, direkt vor dem echten Frame
+          std::vector<uint8_t> junk(1 + rng() % 6);
+          junk[0] = autoterm::FRAME_START;
+          for (size_t i = 1; i < junk.size(); i++)
+            junk[i] = static_cast<uint8_t>(rng());
+          frame.bytes.insert(frame.bytes.begin(), junk.begin(), junk.end());
+          break;
+        }
+        case Disturbance::TRUNCATED:
+          frame.bytes.resize(1 + rng() % (frame.bytes.size() - 1));
+          entry.intact = false;
+          break;
+        default:
+          frame.bytes[rng() % frame.bytes.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+          entry.intact = false;
+          break;
+      }
+    }
+    info.push_back(entry);
+  }
+  return noisy;
+}
+
+// Merkt sich, wann CRC-gültige Frames je Richtung erkannt wurden
+class NoiseListener : public ReplayListener {
+ public:
+  void on_frame(const autoterm::BridgeChannel &channel, const uint8_t *frame, size_t length,
+                bool crc_valid) override {
+    ReplayListener::on_frame(channel, frame, length, crc_valid);
+    if (crc_valid)
+      valid_at[channel.from_display() ? 0 : 1].push_back(now_us);
+  }
+
+  uint32_t now_us{0};
+  std::vector<uint32_t> valid_at[2];
+};
+
+struct NoiseResult {
+  uint32_t disturbances[4]{};
+  uint32_t intact_frames{0};
+  uint32_t lost_frames{0};
+  // Verzögerung, mit der nach einer Störung der erste unversehrte Frame erkannt wird
+  autoterm::Histogram<64, 1000> recovery_us;
+  uint32_t false_starts{0};
+  uint32_t gap_flushes{0};
+  bool byte_exact{true};
+};
+
+void run_noise_replay(const std::vector<CapturedFrame> &frames, bool cut_through, double p, uint32_t seed,
+                      NoiseResult &result) {
+  std::vector<NoisyFrame> info;
+  std::vector<CapturedFrame> noisy = inject_noise(frames, p, seed, info);
+  std::vector<uint32_t> starts;
+  std::vector<ReplayByte> stream = build_stream(noisy, &starts);
+  for (size_t i = 0; i < info.size(); i++) {
+    info[i].start_us = starts[i];
+    info[i].last_byte_us = starts[i] + static_cast<uint32_t>(noisy[i].bytes.size() - 1) * BYTE_TIME_US;
+  }
+
+  autoterm::BridgeChannel channels[2] = {{"display→heater", true}, {"heater→display", false}};
+  RecordingSink sinks[2];
+  NoiseListener listener;
+  for (int i = 0; i < 2; i++)
+    channels[i].set_cut_through(cut_through);
+  for (const auto &b : stream) {
+    listener.now_us = b.time_us;
+    for (int i = 0; i < 2; i++)
+      channels[i].poll_gap(b.time_us, sinks[i]);
+    int dir = b.from_display ? 0 : 1;
+    channels[dir].push(b.value, b.time_us, sinks[dir], listener);
+  }
+
+  for (int dir = 0; dir < 2; dir++) {
+    std::vector<uint8_t> expected;
+    for (const auto &b : stream) {
+      if (b.from_display == (dir == 0))
+        expected.push_back(b.value);
+    }
+    if (sinks[dir].bytes() != expected)
+      result.byte_exact = false;
+    result.false_starts += channels[dir].stats().false_starts.get();
+    result.gap_flushes += channels[dir].stats().gap_flushes.get();
+  }
+
+  size_t decoded[2] = {0, 0};
+  for (const auto &entry : info) {
+    if (entry.intact)
+      result.intact_frames++;
+    result.disturbances[static_cast<size_t>(entry.disturbance)]++;
+  }
+  for (int dir = 0; dir < 2; dir++)
+    decoded[dir] = listener.valid_at[dir].size();
+  result.lost_frames = result.intact_frames - static_cast<uint32_t>(decoded[0] + decoded[1]);
+
+  // Für jede Störung: nächster unversehrter Frame derselben Richtung (bei JUNK der
+  // Frame selbst) und erster danach erkannter gültiger Frame
+  for (size_t i = 0; i < info.size(); i++) {
+    if (info[i].disturbance == Disturbance::NONE)
+      continue;
+    int dir = info[i].from_display ? 0 : 1;
+    size_t next = i;
+    while (next < info.size() && (!info[next].intact || info[next].from_display != info[i].from_display))
+      next++;
+    if (next == info.size())
+      continue;
+    const std::vector<uint32_t> &valid = listener.valid_at[dir];
+    auto it = std::lower_bound(valid.begin(), valid.end(), info[i].start_us);
+    if (it == valid.end())
+      continue;
+    uint32_t ideal = info[next].last_byte_us;
+    result.recovery_us.add(*it > ideal ? *it - ideal : 0);
+  }
+}
+
+void print_latency(const char *tag, const LatencySummary &latency) {
+  std::printf("  %-15s forward latency avg=%6uus max=%6uus (%u frames)\n", tag,
+              static_cast<unsigned>(latency.average_us), static_cast<unsigned>(latency.max_us),
+              static_cast<unsigned>(latency.count));
+}
+
+// ===================
+// Szenario-Prüfungen
+// ===================
+// Gezielte Abläufe des Kerns, die im Mitschnitt nicht vorkommen. --checks führt
+// sie ohne Log-Datei aus; jede Abweichung setzt den Exit-Code.
+int g_check_failures = 0;
+
+void expect(bool ok, const char *what) {
+  std::printf("  %-64s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok)
+    g_check_failures++;
+}
+
+// Anfrage des Bedienteils übernimmt den Slot einer eigenen Wiederholung
+void check_request_tracker_takeover() {
+  const auto &status = autoterm::STATUS_REQUEST_FRAME;
+  autoterm::RequestTracker tracker;
+  autoterm::ScheduledCommand retry;
+  tracker.on_request(status.data(), status.size(), 0, true, "request.status");
+  expect(tracker.poll(250, retry), "tracker: own status request handed out for retry");
+  tracker.on_request(status.data(), status.size(), 300, false, nullptr);
+  expect(!tracker.poll(300 + 2000, retry), "tracker: display request is not retried as our own");
+  expect(tracker.stats().timeouts == 1 && tracker.stats().retries == 1, "tracker: one retry, one timeout");
+
+  autoterm::RequestTracker replied;
+  replied.on_request(status.data(), status.size(), 0, true, "request.status");
+  replied.poll(250, retry);
+  replied.on_request(status.data(), status.size(), 300, false, nullptr);
+  replied.on_response(autoterm::CMD_STATUS, 340);
+  expect(replied.latency().max() == 40, "tracker: latency measured from the display request");
+}
+
+// Verworfene Wiederholung und Übergabe an das Bedienteil zählen weder Timeout noch Latenz
+void check_request_tracker_cancel() {
+  const auto &status = autoterm::STATUS_REQUEST_FRAME;
+  autoterm::RequestTracker tracker;
+  autoterm::ScheduledCommand retry;
+  tracker.on_request(status.data(), status.size(), 0, true, "request.status");
+  expect(tracker.poll(250, retry), "cancel: own status request handed out for retry");
+  tracker.cancel(retry.frame[4]);
+  expect(!tracker.in_flight(autoterm::CMD_STATUS), "cancel: abandoned retry frees the slot");
+  expect(!tracker.poll(250 + 2000, retry), "cancel: nothing left to retry");
+  expect(tracker.stats().timeouts == 0 && tracker.stats().retries == 0, "cancel: no timeout, no retry counted");
+
+  tracker.on_request(status.data(), status.size(), 3000, true, "request.status");
+  tracker.cancel_own();
+  tracker.on_request(status.data(), status.size(), 3100, false, nullptr);
+  tracker.on_response(autoterm::CMD_STATUS, 3130);
+  expect(!tracker.poll(3130 + 2000, retry) && tracker.stats().timeouts == 0, "cancel: handover is no timeout");
+  expect(tracker.latency().max() == 30, "cancel: latency measured from the display request");
+}
+
+// Antwort der Heizung ersetzt die vorläufigen Settings aus dem Flash
+void check_settings_reconcile() {
+  autoterm::Settings restored;
+  restored.temperature_source = 1;
+  restored.set_temperature = 18;
+  restored.wait_mode = 0x02;
+  restored.power_level = 2;
+
+  uint8_t reply[] = {0xAA, 0x04, 0x06, 0x00, autoterm::CMD_SETTINGS, 0x01, 0x00, 0x04, 0x10, 0x00, 0x07, 0x00, 0x00};
+  uint16_t crc = autoterm::crc16_modbus(reply, sizeof(reply) - 2);
+  reply[sizeof(reply) - 2] = static_cast<uint8_t>(crc >> 8);
+  reply[sizeof(reply) - 1] = static_cast<uint8_t>(crc & 0xFF);
+  autoterm::Settings confirmed = restored;
+  expect(autoterm::decode_settings(reply, sizeof(reply), confirmed), "settings: heater reply decoded");
+  expect(autoterm::settings_mode(restored) == autoterm::SettingsMode::HEAT &&
+             autoterm::settings_mode(confirmed) == autoterm::SettingsMode::POWER,
+         "settings: restored temperature hold replaced by heater power mode");
+  expect(confirmed.power_level == 7, "settings: level taken from the heater reply");
+
+  confirmed.wait_mode = 0x00;
+  confirmed.power_level = 0;
+  expect(autoterm::settings_mode(confirmed) == autoterm::SettingsMode::STANDBY, "settings: standby reply maps to off");
+}
+
+// Der UART-Treiber liefert den Rest eines Frames erst nach seinem RX-Timeout
+void check_late_rx_delivery() {
+  const auto &frame = autoterm::STATUS_REQUEST_FRAME;
+  const uint32_t char_us = 10 * 1000000UL / 9600;
+  autoterm::BridgeChannel channel("display→heater", true);
+  RecordingSink sink;
+  ReplayListener listener;
+  channel.push(frame.data(), 3, 0, sink, listener);
+  channel.poll_gap(12 * char_us, sink);
+  channel.push(frame.data() + 3, frame.size() - 3, 12 * char_us, sink, listener);
+  channel.poll_gap(12 * char_us, sink);
+  expect(listener.frames == 1 && listener.crc_errors == 0, "gap: frame delivered 12 characters late still assembled");
+  expect(channel.stats().gap_flushes.get() == 0, "gap: late delivery is no gap flush");
+  expect(sink.bytes() == std::vector<uint8_t>(frame.begin(), frame.end()), "gap: forwarded bytes unchanged");
+
+  const uint32_t later_us = 1000000;
+  channel.push(frame.data(), 3, later_us, sink, listener);
+  channel.poll_gap(later_us + 20 * char_us, sink);
+  expect(channel.stats().gap_flushes.get() == 1 && channel.idle(), "gap: real line pause flushes the partial frame");
+}
+
+bool run_checks() {
+  std::printf("scenario checks:\n");
+  check_request_tracker_takeover();
+  check_request_tracker_cancel();
+  check_settings_reconcile();
+  check_late_rx_delivery();
+  return g_check_failures == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::vector<const char *> files;
+  bool cut_through = false;
+  unsigned iterations = 20;
+  uint32_t poll_us = 16000;
+  double noise = 0.0;
+  uint32_t seed = 1;
+  bool checks = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--checks") == 0) {
+      checks = true;
+    } else if (std::strcmp(argv[i], "--cut-through") == 0) {
+      cut_through = true;
+    } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    } else if (std::strcmp(argv[i], "--poll-ms") == 0 && i + 1 < argc) {
+      poll_us = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i]))) * 1000;
+    } else if (std::strcmp(argv[i], "--noise") == 0 && i + 1 < argc) {
+      noise = std::min(1.0, std::max(0.0, std::atof(argv[++i])));
+    } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = static_cast<uint32_t>(std::atoi(argv[++i]));
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty() && !checks) {
+    std::fprintf(stderr,
+                 "usage: %s <log>... [--cut-through] [--iterations N] [--poll-ms N] [--noise P] [--seed N] [--checks]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  int exit_code = 0;
+  if (checks && !run_checks())
+    exit_code = 1;
+  for (const char *path : files) {
+    std::vector<CapturedFrame> frames;
+    if (!load_capture(path, frames)) {
+      std::fprintf(stderr, "%s: cannot open\n", path);
+      exit_code = 1;
+      continue;
+    }
+    std::vector<ReplayByte> stream = build_stream(frames);
+    std::vector<uint8_t> expected[2];
+    for (const auto &b : stream)
+      expected[b.from_display ? 0 : 1].push_back(b.value);
+
+    RecordingSink sinks[2];
+    sinks[0].reserve(expected[0].size());
+    sinks[1].reserve(expected[1].size());
+
+    ReplayResult result;
+    for (unsigned n = 0; n < iterations; n++)
+      run_replay(stream, cut_through, result, sinks, expected);
+
+    double total_frames = static_cast<double>(result.listener.frames);
+    double seconds = result.cpu_ns / 1e9;
+    double span_s = stream.empty() ? 0.0 : stream.back().time_us / 1e6;
+
+    std::printf("%s: %zu frames, %zu bytes, %.1f s of traffic (%s)\n", path, frames.size(), stream.size(), span_s,
+                cut_through ? "cut-through" : "store-and-forward");
+    std::printf("  decoded: status=%u settings=%u crc_errors=%u\n", result.listener.status_frames / iterations,
+                result.listener.settings_frames / iterations, result.listener.crc_errors / iterations);
+    std::printf("  throughput: %.0f frames/s, %.0f ns CPU per frame\n", seconds > 0 ? total_frames / seconds : 0.0,
+                total_frames > 0 ? result.cpu_ns / total_frames : 0.0);
+    std::printf("  allocations: %zu (%.3f per frame)\n", result.allocations,
+                total_frames > 0 ? result.allocations / total_frames : 0.0);
+    print_latency("display→heater", result.latency[0]);
+    print_latency("heater→display", result.latency[1]);
+    std::printf("  forwarded output: %s\n", result.byte_exact ? "byte-exact" : "MISMATCH");
+    if (!result.byte_exact || result.allocations != 0)
+      exit_code = 1;
+
+    BulkResult bulk;
+    run_bulk_replay(stream, cut_through, poll_us, bulk, sinks, expected);
+    const ReplayListener &byte_wise = result.listener;
+    bool same_frames = bulk.listener.frames * iterations == byte_wise.frames &&
+                       bulk.listener.status_frames * iterations == byte_wise.status_frames &&
+                       bulk.listener.settings_frames * iterations == byte_wise.settings_frames &&
+                       bulk.listener.crc_errors * iterations == byte_wise.crc_errors;
+    std::printf("  bulk rx (poll %ums): %u reads in %u polls (%.2f bytes/read)\n",
+                static_cast<unsigned>(poll_us / 1000), static_cast<unsigned>(bulk.reads),
+                static_cast<unsigned>(bulk.polls), bulk.reads > 0 ? double(stream.size()) / bulk.reads : 0.0);
+    print_latency("display→heater", bulk.latency[0]);
+    print_latency("heater→display", bulk.latency[1]);
+    std::printf("  bulk forwarded output: %s, decoded frames: %s\n", bulk.byte_exact ? "byte-exact" : "MISMATCH",
+                same_frames ? "identical" : "MISMATCH");
+    if (!bulk.byte_exact || !same_frames)
+      exit_code = 1;
+
+    if (noise > 0.0) {
+      NoiseResult noisy;
+      run_noise_replay(frames, cut_through, noise, seed, noisy);
+      std::printf("  noise p=%.3f: junk=%u truncated=%u flipped=%u\n", noise,
+                  static_cast<unsigned>(noisy.disturbances[1]), static_cast<unsigned>(noisy.disturbances[2]),
+                  static_cast<unsigned>(noisy.disturbances[3]));
+      std::printf("  intact frames: %u, lost: %u, false_starts=%u gap_flushes=%u\n",
+                  static_cast<unsigned>(noisy.intact_frames), static_cast<unsigned>(noisy.lost_frames),
+                  static_cast<unsigned>(noisy.false_starts), static_cast<unsigned>(noisy.gap_flushes));
+      std::printf("  recovery delay avg=%6uus p95=%6uus max=%6uus (%u disturbances)\n",
+                  static_cast<unsigned>(noisy.recovery_us.average()),
+                  static_cast<unsigned>(noisy.recovery_us.percentile(95)),
+                  static_cast<unsigned>(noisy.recovery_us.max()), static_cast<unsigned>(noisy.recovery_us.count()));
+      std::printf("  noisy forwarded output: %s\n", noisy.byte_exact ? "byte-exact" : "MISMATCH");
+      if (!noisy.byte_exact)
+        exit_code = 1;
+    }
+  }
+  return exit_code;
+}
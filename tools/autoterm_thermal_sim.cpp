@@ -0,0 +1,330 @@
+// ======================
+// Autoterm Thermostat-Simulation
+// ======================
+// Treibt die ThermostatEngine des Protokoll-Kerns gegen ein einfaches
+// Kabinenmodell: Heizleistung je Stufe, Wärmeverlust nach außen über UA,
+// Sensor mit Verzögerung erster Ordnung und 1 °C-Auflösung. Die Heizung läuft
+// dabei durch dieselben Statuscodes wie die echte (Zündung, Heizen, Abkühlen,
+// Nachlauf), Statusabfragen kommen wie im Adapter einmal pro Sekunde.
+//
+// Ein 24-h-Szenario ist in Sekundenbruchteilen durch. Ausgegeben werden
+// Brennerstarts, Zeit unter/über dem Band, Kraftstoff-Proxy (Pumpe Hz·s) und
+// die gesendeten Kommandos. --sweep rechnet alle Hysterese-Kombinationen durch.
+//
+// Bauen und Starten (aus dem Repository-Root):
+//   g++ -std=c++17 -O2 -I components/autoterm_uart -o autoterm_thermal_sim
+//       tools/autoterm_thermal_sim.cpp components/autoterm_uart/autoterm_protocol.cpp
+//   ./autoterm_thermal_sim [--hours N] [--target C] [--hys-on C] [--hys-off C] [--level N]
+//       [--outside C] [--outside-swing C] [--ua W/K] [--capacity kJ/K] [--sensor-tau-s N] [--sweep]
+#include "autoterm_protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+static constexpr uint32_t STEP_MS = 100;
+static constexpr uint32_t STATUS_INTERVAL_MS = 1000;
+static constexpr double PI = 3.14159265358979323846;
+
+struct PlantOptions {
+  double hours{24.0};
+  double outside_c{-5.0};
+  double outside_swing_c{5.0};  // Tagesgang: Minimum um 3 Uhr, Maximum um 15 Uhr
+  double start_c{10.0};
+  double ua_w_per_k{40.0};
+  double capacity_kj_per_k{250.0};
+  double sensor_tau_s{60.0};
+};
+
+// ===================
+// Heizung
+// ===================
+// Stark vereinfachte Air 2D: Leistung und Pumpe linear über die Stufen 0..9.
+// Zündung und Nachlauf dauern wie beim echten Gerät mehrere Minuten.
+struct Phase {
+  uint16_t code;
+  uint32_t duration_ms;
+  uint16_t next;
+};
+
+static constexpr Phase PHASES[] = {
+    {0x0200, 10000, 0x0201}, {0x0201, 40000, 0x0202}, {0x0202, 20000, 0x0203},
+    {0x0203, 20000, 0x0204}, {0x0204, 60000, 0x0300}, {0x0304, 180000, 0x0323},
+    {0x0305, 60000, 0x0001},
+};
+
+class SimulatedHeater {
+ public:
+  static constexpr double MIN_POWER_W = 850.0;
+  static constexpr double MAX_POWER_W = 2000.0;
+
+  void start(uint32_t now_ms) {
+    // Abkühlen und Nachlauf laufen zu Ende, der Start geht verloren
+    if (code_ == 0x0001)
+      enter_(0x0200, now_ms);
+  }
+  void set_level(uint8_t level) { level_ = std::min<uint8_t>(level, 9); }
+  // Drossel-Kommando (Heizen+Lüften, Solltemperatur unter Raumtemperatur)
+  void throttle(uint32_t now_ms) {
+    if (code_ >= 0x0200 && code_ <= 0x0300)
+      enter_(0x0304, now_ms);
+  }
+  void standby(uint32_t now_ms) {
+    if (code_ == 0x0323)
+      enter_(0x0305, now_ms);
+    else if (code_ >= 0x0200 && code_ <= 0x0300)
+      enter_(0x0304, now_ms);
+    standby_requested_ = code_ != 0x0001;
+  }
+
+  void step(uint32_t now_ms) {
+    for (const auto &phase : PHASES) {
+      if (phase.code != code_ || now_ms - entered_ms_ < phase.duration_ms)
+        continue;
+      uint16_t next = phase.next;
+      // Nach dem Abkühlen geht es ohne Standby in die Lüftung (0x0323)
+      if (next == 0x0323 && standby_requested_)
+        next = 0x0305;
+      enter_(next, now_ms);
+      break;
+    }
+  }
+
+  double power_w() const {
+    double full = MIN_POWER_W + (MAX_POWER_W - MIN_POWER_W) * level_ / 9.0;
+    if (code_ == 0x0300)
+      return full;
+    if (code_ >= 0x0202 && code_ <= 0x0204)
+      return full * 0.3;
+    if (code_ == 0x0304)
+      return full * 0.1;
+    return 0.0;
+  }
+  double pump_hz() const {
+    if (code_ == 0x0300)
+      return 0.70 + 0.20 * level_;
+    if (code_ >= 0x0202 && code_ <= 0x0204)
+      return 0.50;
+    return 0.0;
+  }
+  bool burning() const { return code_ >= 0x0202 && code_ <= 0x0300; }
+  uint16_t code() const { return code_; }
+  uint32_t starts() const { return starts_; }
+
+ protected:
+  void enter_(uint16_t code, uint32_t now_ms) {
+    if (code == 0x0200)
+      starts_++;
+    if (code == 0x0001)
+      standby_requested_ = false;
+    code_ = code;
+    entered_ms_ = now_ms;
+  }
+
+  uint16_t code_{0x0001};
+  uint8_t level_{4};
+  uint32_t entered_ms_{0};
+  uint32_t starts_{0};
+  bool standby_requested_{false};
+};
+
+// ===================
+// Ergebnis
+// ===================
+struct SimResult {
+  uint32_t burner_starts{0};
+  double below_band_s{0.0};
+  double above_band_s{0.0};
+  double burner_s{0.0};
+  double fuel_hz_s{0.0};
+  double abs_error_c_s{0.0};
+  double min_c{1e9};
+  double max_c{-1e9};
+  uint32_t actions[7]{};  // je ThermostatAction
+  uint32_t commands{0};
+};
+
+static const char *const ACTION_NAMES[] = {"none", "start", "set_level", "claim", "adjust_level", "cooldown", "standby"};
+
+SimResult run(const PlantOptions &plant, const autoterm::ThermostatConfig &config) {
+  SimResult result;
+  SimulatedHeater heater;
+  heater.set_level(config.level);
+  autoterm::ThermostatEngine engine;
+  engine.configure(config, 1);
+
+  const double dt_s = STEP_MS / 1000.0;
+  const double capacity_j_per_k = plant.capacity_kj_per_k * 1000.0;
+  const double on_threshold = config.target_c - config.hys_on_c;
+  const double off_threshold = config.target_c + config.hys_off_c;
+  double cabin_c = plant.start_c;
+  double sensor_c = plant.start_c;
+  bool heater_running = false;
+  const uint32_t end_ms = static_cast<uint32_t>(plant.hours * 3600.0 * 1000.0);
+
+  auto apply = [&](autoterm::ThermostatAction action, uint32_t now) {
+    result.actions[static_cast<size_t>(action)]++;
+    switch (action) {
+      case autoterm::ThermostatAction::START:
+        heater.set_level(config.level);
+        heater.start(now);
+        result.commands++;
+        break;
+      case autoterm::ThermostatAction::SET_LEVEL:
+      case autoterm::ThermostatAction::ADJUST_LEVEL:
+        heater.set_level(config.level);
+        result.commands++;
+        break;
+      case autoterm::ThermostatAction::COOLDOWN:
+        heater.throttle(now);
+        result.commands++;
+        break;
+      case autoterm::ThermostatAction::STANDBY:
+        heater.standby(now);
+        result.commands++;
+        break;
+      default:
+        break;
+    }
+  };
+
+  // Startzeit 1 ms: 0 bedeutet im Engine "noch kein Kommando"
+  for (uint32_t now = 1; now < end_ms; now += STEP_MS) {
+    double hour = now / 3600000.0;
+    double outside_c = plant.outside_c - plant.outside_swing_c * std::cos(2.0 * PI * (hour - 3.0) / 24.0);
+
+    heater.step(now);
+    double loss_w = plant.ua_w_per_k * (cabin_c - outside_c);
+    cabin_c += (heater.power_w() - loss_w) * dt_s / capacity_j_per_k;
+    sensor_c += (cabin_c - sensor_c) * std::min(1.0, dt_s / std::max(plant.sensor_tau_s, dt_s));
+    // Der Innensensor der Heizung meldet ganze Grad
+    double reported_c = std::round(sensor_c);
+
+    // Wie im Adapter: Status pro Sekunde, danach erzwungene Auswertung
+    if (now % STATUS_INTERVAL_MS == 1) {
+      heater_running = autoterm::is_heater_active_status(heater.code());
+      apply(engine.on_status(heater.code(), now), now);
+      if (engine.active() && !engine.waiting_for_idle())
+        apply(engine.evaluate(static_cast<float>(reported_c), heater_running, now, true), now);
+    } else {
+      apply(engine.evaluate(static_cast<float>(reported_c), heater_running, now, false), now);
+    }
+
+    if (cabin_c < on_threshold)
+      result.below_band_s += dt_s;
+    else if (cabin_c > off_threshold)
+      result.above_band_s += dt_s;
+    if (heater.burning())
+      result.burner_s += dt_s;
+    result.fuel_hz_s += heater.pump_hz() * dt_s;
+    result.abs_error_c_s += std::fabs(cabin_c - config.target_c) * dt_s;
+    result.min_c = std::min(result.min_c, cabin_c);
+    result.max_c = std::max(result.max_c, cabin_c);
+  }
+  result.burner_starts = heater.starts();
+  return result;
+}
+
+void print_result(const PlantOptions &plant, const autoterm::ThermostatConfig &config, const SimResult &result) {
+  double total_s = plant.hours * 3600.0;
+  std::printf("target %.1f°C band [%.1f, %.1f] level %u, outside %.1f±%.1f°C, %.1f h\n", config.target_c,
+              config.target_c - config.hys_on_c, config.target_c + config.hys_off_c,
+              static_cast<unsigned>(config.level), plant.outside_c, plant.outside_swing_c, plant.hours);
+  std::printf("  burner starts: %u, burner on %.1f%%\n", static_cast<unsigned>(result.burner_starts),
+              100.0 * result.burner_s / total_s);
+  std::printf("  below band %.1f%% (%.0f s), above band %.1f%% (%.0f s)\n", 100.0 * result.below_band_s / total_s,
+              result.below_band_s, 100.0 * result.above_band_s / total_s, result.above_band_s);
+  std::printf("  cabin min %.1f°C max %.1f°C, mean |error| %.2f°C\n", result.min_c, result.max_c,
+              result.abs_error_c_s / total_s);
+  std::printf("  fuel proxy: %.0f pump Hz·s (%.0f pulses)\n", result.fuel_hz_s, result.fuel_hz_s);
+  std::printf("  commands: %u (", static_cast<unsigned>(result.commands));
+  bool first = true;
+  for (size_t i = 1; i < sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]); i++) {
+    if (result.actions[i] == 0)
+      continue;
+    std::printf("%s%s=%u", first ? "" : " ", ACTION_NAMES[i], static_cast<unsigned>(result.actions[i]));
+    first = false;
+  }
+  std::printf(")\n");
+}
+
+// Alle Kombinationen aus dem Wertebereich des Adapters (hys_on 1..5, hys_off 0..2)
+void sweep(const PlantOptions &plant, autoterm::ThermostatConfig config) {
+  std::printf("hys_on hys_off  starts  below%%  above%%  |err|  fuel Hz·s  commands\n");
+  for (float hys_on = 1.0f; hys_on <= 5.0f; hys_on += 1.0f) {
+    for (float hys_off = 0.0f; hys_off <= 2.0f; hys_off += 0.5f) {
+      config.hys_on_c = hys_on;
+      config.hys_off_c = hys_off;
+      SimResult result = run(plant, config);
+      double total_s = plant.hours * 3600.0;
+      std::printf("%6.1f %7.1f %7u %7.1f %7.1f %6.2f %10.0f %9u\n", hys_on, hys_off,
+                  static_cast<unsigned>(result.burner_starts), 100.0 * result.below_band_s / total_s,
+                  100.0 * result.above_band_s / total_s, result.abs_error_c_s / total_s, result.fuel_hz_s,
+                  static_cast<unsigned>(result.commands));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  PlantOptions plant;
+  autoterm::ThermostatConfig config;
+  bool do_sweep = false;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (std::strcmp(arg, "--sweep") == 0) {
+      do_sweep = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "%s: missing value\n", arg);
+      return 2;
+    }
+    double value = std::atof(argv[++i]);
+    if (std::strcmp(arg, "--hours") == 0) {
+      plant.hours = std::max(0.1, value);
+    } else if (std::strcmp(arg, "--target") == 0) {
+      config.target_c = static_cast<float>(value);
+    } else if (std::strcmp(arg, "--hys-on") == 0) {
+      config.hys_on_c = static_cast<float>(value);
+    } else if (std::strcmp(arg, "--hys-off") == 0) {
+      config.hys_off_c = static_cast<float>(value);
+    } else if (std::strcmp(arg, "--level") == 0) {
+      config.level = static_cast<uint8_t>(std::min(9.0, std::max(0.0, value)));
+    } else if (std::strcmp(arg, "--outside") == 0) {
+      plant.outside_c = value;
+    } else if (std::strcmp(arg, "--outside-swing") == 0) {
+      plant.outside_swing_c = value;
+    } else if (std::strcmp(arg, "--start") == 0) {
+      plant.start_c = value;
+    } else if (std::strcmp(arg, "--ua") == 0) {
+      plant.ua_w_per_k = std::max(1.0, value);
+    } else if (std::strcmp(arg, "--capacity") == 0) {
+      plant.capacity_kj_per_k = std::max(1.0, value);
+    } else if (std::strcmp(arg, "--sensor-tau-s") == 0) {
+      plant.sensor_tau_s = std::max(0.0, value);
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--hours N] [--target C] [--hys-on C] [--hys-off C] [--level N] [--outside C]\n"
+                   "          [--outside-swing C] [--start C] [--ua W/K] [--capacity kJ/K] [--sensor-tau-s N] [--sweep]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (do_sweep) {
+    sweep(plant, config);
+  } else {
+    print_result(plant, config, run(plant, config));
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::printf("simulated in %.2f s\n", std::chrono::duration<double>(end - start).count());
+  return 0;
+}
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Legt zwei Pseudo-Terminal-Paare für die Host-Bridge an:
+#   /tmp/autoterm/display  <->  /tmp/autoterm/display-peer  (Bedienteil-Seite)
+#   /tmp/autoterm/heater   <->  /tmp/autoterm/heater-peer   (Heizungs-Seite)
+# Die ESPHome-Instanz öffnet display/heater, Testwerkzeuge die *-peer-Enden.
+# Läuft, bis es beendet wird; benötigt socat.
+set -e
+DIR=${AUTOTERM_PTY_DIR:-/tmp/autoterm}
+mkdir -p "$DIR"
+
+socat pty,raw,echo=0,link="$DIR/display" pty,raw,echo=0,link="$DIR/display-peer" &
+DISPLAY_PID=$!
+socat pty,raw,echo=0,link="$DIR/heater" pty,raw,echo=0,link="$DIR/heater-peer" &
+HEATER_PID=$!
+
+trap 'kill $DISPLAY_PID $HEATER_PID 2>/dev/null' INT TERM EXIT
+echo "PTYs ready in $DIR"
+wait